@@ -0,0 +1,321 @@
+/*
+ * bench_monitor.c - Monitor overhead benchmark
+ *
+ * This program measures the cost of sched_monitor.ko on a fixed reference
+ * workload. It populates the process table with a configurable number of
+ * idle and active background processes, optionally with extra threads each
+ * (every sampling pass walks all threads), then runs CPU worker threads
+ * (throughput) alongside a pipe ping-pong pair (wakeup round-trip latency).
+ * Run it once with the module unloaded and once per module configuration;
+ * run_benchmark.sh automates the sweep.
+ *
+ * Output is a single CSV row (use -H for the header line).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <signal.h>
+#include <string.h>
+#include <time.h>
+#include <sys/prctl.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#define DEFAULT_WORKERS 4
+#define DEFAULT_DURATION 10
+#define ACTIVE_PERIOD_US 10000      // Active tasks wake every 10 ms
+#define IDLE_THREAD_STACK (64 * 1024)
+#define MAX_LATENCY_SAMPLES 2000000
+
+volatile int keep_running = 1;
+int threads_per_task = 0;
+
+// Reference workload results
+unsigned long long *worker_ops;
+unsigned long long *rtt_samples;
+unsigned long rtt_count = 0;
+volatile unsigned long long result_sink;   // Keeps the CPU kernel from being optimised out
+
+// Ping-pong pipes: ping[1] -> ping[0] (echo thread) -> pong[1] -> pong[0]
+int ping_fds[2];
+int pong_fds[2];
+
+static unsigned long long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void* idle_thread(void *arg) {
+    (void)arg;
+    for (;;)
+        pause();
+    return NULL;
+}
+
+/*
+ * Background task body: idle tasks block forever, active tasks wake
+ * periodically so their switch counters keep moving between samples.
+ * Extra threads only block; they get no table entry of their own.
+ */
+static void background_task(int active) {
+    pthread_attr_t attr;
+    pthread_t tid;
+
+    prctl(PR_SET_PDEATHSIG, SIGKILL);
+    if (getppid() == 1)
+        _exit(0);
+
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, IDLE_THREAD_STACK);
+    for (int i = 0; i < threads_per_task; i++) {
+        if (pthread_create(&tid, &attr, idle_thread, NULL) != 0)
+            break;      // Shortfall shows up in the system_threads column
+    }
+    pthread_attr_destroy(&attr);
+
+    if (active) {
+        for (;;)
+            usleep(ACTIVE_PERIOD_US);
+    }
+    for (;;)
+        pause();
+}
+
+/*
+ * Fork background processes. Only thread group leaders get a table entry,
+ * so each task must be its own process; the sampler still walks every
+ * thread, which -t adds to. Returns the number actually started.
+ */
+int spawn_tasks(pid_t *pids, int count, int active) {
+    for (int i = 0; i < count; i++) {
+        pid_t pid = fork();
+        if (pid < 0) {
+            perror("fork");
+            return i;
+        }
+        if (pid == 0)
+            background_task(active);
+        pids[i] = pid;
+    }
+    return count;
+}
+
+void reap_tasks(pid_t *pids, int count) {
+    for (int i = 0; i < count; i++)
+        kill(pids[i], SIGKILL);
+    for (int i = 0; i < count; i++)
+        waitpid(pids[i], NULL, 0);
+}
+
+/*
+ * CPU worker - same kernel as test_cpu, counts completed blocks
+ */
+void* cpu_worker(void *arg) {
+    int thread_id = *(int*)arg;
+    unsigned long long local_ops = 0;
+    unsigned long long result = 0;
+
+    while (keep_running) {
+        for (int i = 0; i < 100000; i++) {
+            result += i * i;
+            result = result % 1000000;
+        }
+        local_ops++;
+    }
+
+    worker_ops[thread_id] = local_ops;
+    result_sink = result;
+    free(arg);
+    return NULL;
+}
+
+/*
+ * Echo side of the ping-pong pair
+ */
+void* echo_worker(void *arg) {
+    char token;
+    (void)arg;
+
+    while (read(ping_fds[0], &token, 1) == 1) {
+        if (write(pong_fds[1], &token, 1) != 1)
+            break;
+    }
+    return NULL;
+}
+
+/*
+ * Latency side: time each round trip through the echo thread
+ */
+void* latency_worker(void *arg) {
+    char token = 'x';
+    (void)arg;
+
+    while (keep_running && rtt_count < MAX_LATENCY_SAMPLES) {
+        unsigned long long t0 = now_ns();
+        if (write(ping_fds[1], &token, 1) != 1 ||
+            read(pong_fds[0], &token, 1) != 1)
+            break;
+        rtt_samples[rtt_count++] = now_ns() - t0;
+    }
+
+    close(ping_fds[1]);   // Lets the echo thread exit
+    return NULL;
+}
+
+/*
+ * Threads in the system, from the runnable/total field of /proc/loadavg:
+ * what each sampling pass has to walk. Returns -1 if unavailable.
+ */
+static long system_threads(void) {
+    FILE *fp = fopen("/proc/loadavg", "r");
+    long total = -1;
+
+    if (fp) {
+        if (fscanf(fp, "%*s %*s %*s %*d/%ld", &total) != 1)
+            total = -1;
+        fclose(fp);
+    }
+    return total;
+}
+
+static int cmp_u64(const void *a, const void *b) {
+    unsigned long long x = *(const unsigned long long*)a;
+    unsigned long long y = *(const unsigned long long*)b;
+    return (x > y) - (x < y);
+}
+
+static double percentile_us(double pct) {
+    unsigned long idx;
+
+    if (rtt_count == 0)
+        return 0.0;
+    idx = (unsigned long)(pct / 100.0 * (rtt_count - 1));
+    return rtt_samples[idx] / 1000.0;
+}
+
+void usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s [-i idle_tasks] [-a active_tasks] [-t threads] [-w workers] [-d duration] [-H]\n"
+            "  -i  idle background processes (default: 0)\n"
+            "  -a  active background processes, wake every %d ms (default: 0)\n"
+            "  -t  extra idle threads in each background process (default: 0)\n"
+            "  -w  CPU worker threads in the reference workload (default: %d)\n"
+            "  -d  measurement duration in seconds (default: %d)\n"
+            "  -H  print the CSV header line and exit\n",
+            prog, ACTIVE_PERIOD_US / 1000, DEFAULT_WORKERS, DEFAULT_DURATION);
+}
+
+int main(int argc, char *argv[]) {
+    int idle_tasks = 0;
+    int active_tasks = 0;
+    int num_workers = DEFAULT_WORKERS;
+    int duration = DEFAULT_DURATION;
+    int started_idle, started_active;
+    long nr_threads;
+    unsigned long long total_ops = 0;
+    unsigned long long start, end;
+    double elapsed;
+    pid_t *pids;
+    pthread_t *threads;
+    pthread_t echo_thread, latency_thread;
+    int opt;
+
+    // Parse arguments
+    while ((opt = getopt(argc, argv, "i:a:t:w:d:H")) != -1) {
+        switch (opt) {
+        case 'i': idle_tasks = atoi(optarg); break;
+        case 'a': active_tasks = atoi(optarg); break;
+        case 't': threads_per_task = atoi(optarg); break;
+        case 'w': num_workers = atoi(optarg); break;
+        case 'd': duration = atoi(optarg); break;
+        case 'H':
+            printf("idle_tasks,active_tasks,threads_per_task,system_threads,workers,duration_s,ops_per_sec,"
+                   "rtt_samples,rtt_p50_us,rtt_p99_us,rtt_p999_us,rtt_max_us\n");
+            return 0;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (idle_tasks < 0 || active_tasks < 0 || threads_per_task < 0 || num_workers < 1 || duration < 1) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    pids = malloc((idle_tasks + active_tasks + 1) * sizeof(pid_t));
+    threads = malloc(num_workers * sizeof(pthread_t));
+    worker_ops = calloc(num_workers, sizeof(*worker_ops));
+    rtt_samples = malloc(MAX_LATENCY_SAMPLES * sizeof(*rtt_samples));
+    if (!pids || !threads || !worker_ops || !rtt_samples) {
+        perror("Failed to allocate benchmark buffers");
+        return 1;
+    }
+
+    // Populate the process table before measuring
+    started_idle = spawn_tasks(pids, idle_tasks, 0);
+    started_active = spawn_tasks(pids + started_idle, active_tasks, 1);
+    if (started_idle < idle_tasks || started_active < active_tasks) {
+        fprintf(stderr, "Warning: started %d/%d idle and %d/%d active tasks "
+                "(check ulimit -u and kernel.pid_max)\n",
+                started_idle, idle_tasks, started_active, active_tasks);
+    }
+
+    // Let at least one sampling pass see the new tasks
+    sleep(2);
+    nr_threads = system_threads();
+
+    if (pipe(ping_fds) < 0 || pipe(pong_fds) < 0) {
+        perror("pipe");
+        reap_tasks(pids, started_idle + started_active);
+        return 1;
+    }
+
+    start = now_ns();
+
+    for (int i = 0; i < num_workers; i++) {
+        int *thread_id = malloc(sizeof(int));
+        *thread_id = i;
+        if (pthread_create(&threads[i], NULL, cpu_worker, thread_id) != 0) {
+            perror("Failed to create worker thread");
+            free(thread_id);
+            num_workers = i;
+            break;
+        }
+    }
+    pthread_create(&echo_thread, NULL, echo_worker, NULL);
+    pthread_create(&latency_thread, NULL, latency_worker, NULL);
+
+    // Run for specified duration
+    sleep(duration);
+    keep_running = 0;
+
+    for (int i = 0; i < num_workers; i++) {
+        pthread_join(threads[i], NULL);
+        total_ops += worker_ops[i];
+    }
+    pthread_join(latency_thread, NULL);
+    pthread_join(echo_thread, NULL);
+
+    end = now_ns();
+    elapsed = (end - start) / 1e9;
+
+    reap_tasks(pids, started_idle + started_active);
+
+    qsort(rtt_samples, rtt_count, sizeof(*rtt_samples), cmp_u64);
+
+    printf("%d,%d,%d,%ld,%d,%.3f,%.2f,%lu,%.2f,%.2f,%.2f,%.2f\n",
+           started_idle, started_active, threads_per_task, nr_threads, num_workers, elapsed,
+           total_ops / elapsed, rtt_count,
+           percentile_us(50.0), percentile_us(99.0), percentile_us(99.9),
+           percentile_us(100.0));
+
+    free(pids);
+    free(threads);
+    free(worker_ops);
+    free(rtt_samples);
+    return 0;
+}
@@ -0,0 +1,280 @@
+#!/usr/bin/env python3
+"""
+Statistical Report for Scheduling Policy A/B Runs
+
+This script reads a run directory produced by run_policy_matrix.sh and
+summarises every metric per configuration (policy, nice, affinity): mean,
+standard deviation and confidence interval over the repeats, plus a Welch
+t-test against the baseline configuration.
+
+Usage:
+    python3 compare_policies.py results/policy_<timestamp>
+    python3 compare_policies.py results/policy_<timestamp> --csv summary.csv
+
+Options:
+    run_dir: Directory containing manifest.csv and the per-run files
+    --baseline: Baseline configuration as policy/nice/affinity
+                (default: first configuration in the manifest)
+    --alpha: Significance level (default: 0.05)
+    --csv: Also write the summary table to a CSV file
+"""
+
+import csv
+import json
+import math
+import sys
+import argparse
+from pathlib import Path
+from typing import Dict, List, Optional, Tuple
+
+
+Config = Tuple[str, str, str]   # (policy, nice, affinity)
+
+
+# ---------------------------------------------------------------------------
+# Statistics helpers (no SciPy dependency)
+# ---------------------------------------------------------------------------
+
+def _betacf(a: float, b: float, x: float) -> float:
+    """Continued fraction for the incomplete beta function (modified Lentz)."""
+    tiny = 1e-300
+    qab, qap, qam = a + b, a + 1.0, a - 1.0
+    c, d = 1.0, 1.0 - qab * x / qap
+    d = 1.0 / (d if abs(d) > tiny else tiny)
+    h = d
+    for m in range(1, 300):
+        m2 = 2 * m
+        aa = m * (b - m) * x / ((qam + m2) * (a + m2))
+        d = 1.0 + aa * d
+        d = 1.0 / (d if abs(d) > tiny else tiny)
+        c = 1.0 + aa / c
+        c = c if abs(c) > tiny else tiny
+        h *= d * c
+        aa = -(a + m) * (qab + m) * x / ((a + m2) * (qap + m2))
+        d = 1.0 + aa * d
+        d = 1.0 / (d if abs(d) > tiny else tiny)
+        c = 1.0 + aa / c
+        c = c if abs(c) > tiny else tiny
+        delta = d * c
+        h *= delta
+        if abs(delta - 1.0) < 1e-12:
+            break
+    return h
+
+
+def betainc(a: float, b: float, x: float) -> float:
+    """Regularized incomplete beta function I_x(a, b)."""
+    if x <= 0.0:
+        return 0.0
+    if x >= 1.0:
+        return 1.0
+    ln_front = (math.lgamma(a + b) - math.lgamma(a) - math.lgamma(b)
+                + a * math.log(x) + b * math.log(1.0 - x))
+    if x < (a + 1.0) / (a + b + 2.0):
+        return math.exp(ln_front) * _betacf(a, b, x) / a
+    return 1.0 - math.exp(ln_front) * _betacf(b, a, 1.0 - x) / b
+
+
+def t_two_sided_p(t: float, df: float) -> float:
+    """Two-sided p-value of Student's t distribution."""
+    if df <= 0:
+        return float('nan')
+    return betainc(df / 2.0, 0.5, df / (df + t * t))
+
+
+def t_critical(alpha: float, df: float) -> float:
+    """Critical t value for a two-sided interval at level alpha (bisection)."""
+    lo, hi = 0.0, 1000.0
+    for _ in range(200):
+        mid = (lo + hi) / 2.0
+        if t_two_sided_p(mid, df) > alpha:
+            lo = mid
+        else:
+            hi = mid
+    return (lo + hi) / 2.0
+
+
+def summarize(values: List[float], alpha: float) -> Dict[str, float]:
+    """Mean, standard deviation and confidence half-width."""
+    n = len(values)
+    mean = sum(values) / n if n else float('nan')
+    if n < 2:
+        return {'n': n, 'mean': mean, 'stdev': float('nan'), 'ci': float('nan')}
+    var = sum((v - mean) ** 2 for v in values) / (n - 1)
+    stdev = math.sqrt(var)
+    ci = t_critical(alpha, n - 1) * stdev / math.sqrt(n)
+    return {'n': n, 'mean': mean, 'stdev': stdev, 'ci': ci}
+
+
+def welch_test(a: List[float], b: List[float]) -> float:
+    """Two-sided Welch t-test p-value for a difference in means."""
+    na, nb = len(a), len(b)
+    if na < 2 or nb < 2:
+        return float('nan')
+    ma, mb = sum(a) / na, sum(b) / nb
+    va = sum((v - ma) ** 2 for v in a) / (na - 1)
+    vb = sum((v - mb) ** 2 for v in b) / (nb - 1)
+    se2 = va / na + vb / nb
+    if se2 == 0:
+        return 0.0 if ma != mb else 1.0
+    t = (ma - mb) / math.sqrt(se2)
+    df = se2 ** 2 / ((va / na) ** 2 / (na - 1) + (vb / nb) ** 2 / (nb - 1))
+    return t_two_sided_p(t, df)
+
+
+# ---------------------------------------------------------------------------
+# Run parsing
+# ---------------------------------------------------------------------------
+
+def parse_module_stats(path: Path) -> Tuple[Optional[int], Dict[int, Tuple[int, int, int]]]:
+    """Return (total context switches, {pid: (total, voluntary, involuntary)})."""
+    total = None
+    rows = {}
+    if not path.exists():
+        return total, rows
+    with open(path, 'r') as f:
+        for line in f:
+            if line.startswith('Total Context Switches:'):
+                total = int(line.split(':')[1])
+                continue
+            parts = line.split()
+            if len(parts) >= 8 and parts[0].isdigit():
+                try:
+                    rows[int(parts[0])] = (int(parts[-6]), int(parts[-5]), int(parts[-4]))
+                except ValueError:
+                    continue
+    return total, rows
+
+
+def run_metrics(run_dir: Path, row: Dict[str, str]) -> Dict[str, float]:
+    """Collect every metric for one run."""
+    metrics = {}
+    result_path = run_dir / row['result']
+    if not result_path.exists():
+        return metrics
+
+    with open(result_path, 'r') as f:
+        result = json.load(f)
+    duration = result['duration_s']
+
+    for group in result['groups']:
+        name = group['name']
+        metrics[f'{name}.ops_per_sec'] = group['ops_per_sec']
+        metrics[f'{name}.p50_us'] = group['latency_ns']['p50'] / 1000.0
+        metrics[f'{name}.p99_us'] = group['latency_ns']['p99'] / 1000.0
+
+    ru = result.get('rusage')
+    if ru:
+        metrics['workload.voluntary_cs_per_sec'] = ru['voluntary_cs'] / duration
+        metrics['workload.involuntary_cs_per_sec'] = ru['involuntary_cs'] / duration
+
+    before_total, _ = parse_module_stats(run_dir / row['before'])
+    after_total, after_rows = parse_module_stats(run_dir / row['after'])
+    if before_total is not None and after_total is not None:
+        metrics['module.system_cs_per_sec'] = (after_total - before_total) / duration
+    if result['pid'] in after_rows:
+        metrics['module.leader_cs'] = after_rows[result['pid']][0]
+
+    return metrics
+
+
+def load_runs(run_dir: Path) -> Tuple[List[Config], Dict[Config, Dict[str, List[float]]]]:
+    """Group per-run metrics by configuration, keeping manifest order."""
+    order: List[Config] = []
+    data: Dict[Config, Dict[str, List[float]]] = {}
+
+    with open(run_dir / 'manifest.csv', 'r') as f:
+        for row in csv.DictReader(f):
+            config = (row['policy'], row['nice'], row['affinity'])
+            if config not in data:
+                order.append(config)
+                data[config] = {}
+            for metric, value in run_metrics(run_dir, row).items():
+                data[config].setdefault(metric, []).append(value)
+
+    return order, data
+
+
+def config_label(config: Config) -> str:
+    return f'{config[0]}/nice{config[1]}/cpus:{config[2]}'
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Compare scheduling policy A/B runs with confidence intervals'
+    )
+    parser.add_argument('run_dir', help='Run directory from run_policy_matrix.sh')
+    parser.add_argument('--baseline', default=None,
+                       help='Baseline as policy/nice/affinity (default: first in manifest)')
+    parser.add_argument('--alpha', type=float, default=0.05,
+                       help='Significance level (default: 0.05)')
+    parser.add_argument('--csv', default=None,
+                       help='Write the summary table to this CSV file')
+
+    args = parser.parse_args()
+    run_dir = Path(args.run_dir)
+
+    if not (run_dir / 'manifest.csv').exists():
+        print(f"Error: No manifest.csv in {run_dir}")
+        return 1
+
+    order, data = load_runs(run_dir)
+    if not order:
+        print("Error: Manifest lists no runs")
+        return 1
+
+    baseline = order[0]
+    if args.baseline:
+        parts = tuple(args.baseline.split('/'))
+        if parts not in data:
+            print(f"Error: Baseline {args.baseline} not found in manifest")
+            return 1
+        baseline = parts
+
+    metrics = sorted({m for config in order for m in data[config]})
+    level = int(round((1 - args.alpha) * 100))
+    summary_rows = []
+
+    print(f"Baseline: {config_label(baseline)}")
+    print(f"Intervals: {level}% CI over repeats; '*' marks p < {args.alpha} (Welch t-test)")
+
+    for metric in metrics:
+        base_values = data[baseline].get(metric, [])
+        base_mean = sum(base_values) / len(base_values) if base_values else float('nan')
+
+        print(f"\n=== {metric} ===")
+        print(f"{'Configuration':<32} {'n':>3} {'mean':>14} {'± CI':>12} {'vs base':>9} {'p':>8}")
+        print("-" * 83)
+
+        for config in order:
+            values = data[config].get(metric, [])
+            if not values:
+                continue
+            s = summarize(values, args.alpha)
+            if config == baseline:
+                delta, p = 0.0, float('nan')
+            else:
+                delta = ((s['mean'] - base_mean) / base_mean * 100.0) if base_mean else float('nan')
+                p = welch_test(values, base_values)
+            mark = '*' if (not math.isnan(p) and p < args.alpha) else ''
+            print(f"{config_label(config):<32} {s['n']:>3} {s['mean']:>14.2f} "
+                  f"{s['ci']:>12.2f} {delta:>+8.1f}% {p:>8.4f}{mark}")
+            summary_rows.append({
+                'metric': metric, 'policy': config[0], 'nice': config[1],
+                'affinity': config[2], 'n': s['n'], 'mean': s['mean'],
+                'stdev': s['stdev'], 'ci': s['ci'], 'delta_pct': delta,
+                'p_value': p, 'significant': bool(mark),
+            })
+
+    if args.csv:
+        with open(args.csv, 'w', newline='') as f:
+            writer = csv.DictWriter(f, fieldnames=list(summary_rows[0].keys()))
+            writer.writeheader()
+            writer.writerows(summary_rows)
+        print(f"\n✓ Summary saved to: {args.csv}")
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,353 @@
+/*
+ * latency_probe.c - Wakeup latency probe
+ *
+ * cyclictest-style probe: one thread per CPU sleeps on absolute deadlines
+ * (clock_nanosleep with TIMER_ABSTIME) and records how late each wakeup is
+ * into a 1 us histogram. Run it next to test_cpu/test_mixed/workload_gen to
+ * see how much latency background load adds for a latency-sensitive task.
+ *
+ * Output is JSON Lines on stdout, one object per thread per window plus a
+ * summary per thread at exit. Every record carries pid/tid/cpu and the
+ * window bounds on both CLOCK_REALTIME (start_ns/end_ns, the clock
+ * sched_collector stamps its samples with) and CLOCK_MONOTONIC
+ * (mono_start_ns/mono_end_ns). The module only reports thread-group
+ * leaders, so probe tids never show up in /proc/sched_stats: records join
+ * with collector captures by process pid and time window only.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <signal.h>
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/types.h>
+
+#define DEFAULT_INTERVAL_US 1000
+#define DEFAULT_MAX_US 10000
+#define DEFAULT_DURATION 10
+#define PROBE_STACK_SIZE (256 * 1024)   // Small enough to mlock under the default RLIMIT_MEMLOCK
+
+typedef struct {
+    unsigned long long *buckets;   // 1 us buckets, last one is overflow
+    unsigned long long samples;
+    unsigned long long sum_ns;
+    unsigned long long min_ns;
+    unsigned long long max_ns;
+} histogram_t;
+
+typedef struct {
+    int cpu;
+    pid_t tid;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    histogram_t window;
+    histogram_t spare;             // Swapped with window when flushing
+    histogram_t total;
+} probe_t;
+
+typedef struct {
+    unsigned long long mono;
+    unsigned long long real;
+} stamp_t;
+
+volatile sig_atomic_t keep_running = 1;
+
+// Configuration
+int interval_us = DEFAULT_INTERVAL_US;
+int max_us = DEFAULT_MAX_US;
+int rt_priority = 0;               // 0: stay SCHED_OTHER
+
+static unsigned long long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static stamp_t stamp_now(void) {
+    struct timespec ts;
+    stamp_t st;
+
+    st.mono = now_ns();
+    clock_gettime(CLOCK_REALTIME, &ts);
+    st.real = (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+    return st;
+}
+
+static void handle_signal(int sig) {
+    (void)sig;
+    keep_running = 0;
+}
+
+/*
+ * Histogram helpers
+ */
+static int hist_init(histogram_t *h) {
+    memset(h, 0, sizeof(*h));
+    h->buckets = calloc(max_us + 1, sizeof(*h->buckets));
+    h->min_ns = ~0ULL;
+    return h->buckets ? 0 : -1;
+}
+
+static void hist_reset(histogram_t *h) {
+    memset(h->buckets, 0, (max_us + 1) * sizeof(*h->buckets));
+    h->samples = 0;
+    h->sum_ns = 0;
+    h->min_ns = ~0ULL;
+    h->max_ns = 0;
+}
+
+static void hist_add(histogram_t *h, unsigned long long ns) {
+    unsigned long long us = ns / 1000;
+
+    h->buckets[us < (unsigned long long)max_us ? us : (unsigned long long)max_us]++;
+    h->samples++;
+    h->sum_ns += ns;
+    if (ns < h->min_ns)
+        h->min_ns = ns;
+    if (ns > h->max_ns)
+        h->max_ns = ns;
+}
+
+static long hist_percentile_us(const histogram_t *h, double pct) {
+    unsigned long long target, seen = 0;
+
+    if (h->samples == 0)
+        return 0;
+    target = (unsigned long long)(pct / 100.0 * h->samples);
+    if (target >= h->samples)
+        target = h->samples - 1;
+    for (int i = 0; i <= max_us; i++) {
+        seen += h->buckets[i];
+        if (seen > target)
+            return i;
+    }
+    return max_us;
+}
+
+/*
+ * Probe thread: pinned to one CPU, wakes every interval_us
+ */
+void* probe_thread(void *arg) {
+    probe_t *p = arg;
+    struct timespec next, now;
+    cpu_set_t set;
+    long period_ns = interval_us * 1000L;
+
+    p->tid = syscall(SYS_gettid);
+
+    CPU_ZERO(&set);
+    CPU_SET(p->cpu, &set);
+    if (sched_setaffinity(0, sizeof(set), &set) < 0)
+        fprintf(stderr, "[cpu %d] sched_setaffinity: %s\n", p->cpu, strerror(errno));
+
+    if (rt_priority > 0) {
+        struct sched_param param = { .sched_priority = rt_priority };
+        if (sched_setscheduler(0, SCHED_FIFO, &param) < 0)
+            fprintf(stderr, "[cpu %d] sched_setscheduler: %s\n", p->cpu, strerror(errno));
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    while (keep_running) {
+        long long late_ns;
+
+        next.tv_nsec += period_ns;
+        while (next.tv_nsec >= 1000000000L) {
+            next.tv_nsec -= 1000000000L;
+            next.tv_sec++;
+        }
+        if (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL) != 0)
+            continue;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+
+        late_ns = (now.tv_sec - next.tv_sec) * 1000000000LL + (now.tv_nsec - next.tv_nsec);
+        if (late_ns < 0)
+            late_ns = 0;
+
+        pthread_mutex_lock(&p->lock);
+        hist_add(&p->window, late_ns);
+        hist_add(&p->total, late_ns);
+        pthread_mutex_unlock(&p->lock);
+    }
+    return NULL;
+}
+
+/*
+ * Print one JSON record for a histogram
+ */
+void print_record(const char *type, const probe_t *p, const histogram_t *h,
+                  stamp_t start, stamp_t end) {
+    int first = 1;
+
+    printf("{\"type\": \"%s\", \"pid\": %d, \"tid\": %d, \"cpu\": %d, "
+           "\"start_ns\": %llu, \"end_ns\": %llu, "
+           "\"mono_start_ns\": %llu, \"mono_end_ns\": %llu, \"samples\": %llu, ",
+           type, getpid(), p->tid, p->cpu, start.real, end.real,
+           start.mono, end.mono, h->samples);
+    printf("\"min_us\": %.3f, \"avg_us\": %.3f, \"max_us\": %.3f, "
+           "\"p50_us\": %ld, \"p99_us\": %ld, \"p999_us\": %ld, \"overflows\": %llu, ",
+           h->samples ? h->min_ns / 1000.0 : 0.0,
+           h->samples ? (double)h->sum_ns / h->samples / 1000.0 : 0.0,
+           h->max_ns / 1000.0,
+           hist_percentile_us(h, 50.0), hist_percentile_us(h, 99.0),
+           hist_percentile_us(h, 99.9), h->buckets[max_us]);
+
+    // Sparse histogram: {"<us>": count, ...}
+    printf("\"hist_us\": {");
+    for (int i = 0; i < max_us; i++) {
+        if (h->buckets[i] == 0)
+            continue;
+        printf("%s\"%d\": %llu", first ? "" : ", ", i, h->buckets[i]);
+        first = 0;
+    }
+    printf("}}\n");
+}
+
+void usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s [-c cpus] [-i interval_us] [-d duration] [-w window_s] [-m max_us] [-p rt_prio]\n"
+            "  -c  probe at most this many CPUs (default: every CPU in the affinity mask)\n"
+            "  -i  wakeup interval in microseconds (default: %d)\n"
+            "  -d  duration in seconds, 0 runs until SIGINT (default: %d)\n"
+            "  -w  emit a record per thread every window_s seconds (default: summary only)\n"
+            "  -m  histogram range in microseconds, later wakeups count as overflows (default: %d)\n"
+            "  -p  run probe threads as SCHED_FIFO with this priority (default: SCHED_OTHER)\n",
+            prog, DEFAULT_INTERVAL_US, DEFAULT_DURATION, DEFAULT_MAX_US);
+}
+
+int main(int argc, char *argv[]) {
+    int num_cpus = 0;
+    int max_cpus = 0;
+    cpu_set_t allowed;
+    int duration = DEFAULT_DURATION;
+    int window_s = 0;
+    stamp_t start, window_start, end;
+    probe_t *probes;
+    pthread_attr_t attr;
+    struct sigaction sa;
+    int opt;
+
+    // Parse arguments
+    while ((opt = getopt(argc, argv, "c:i:d:w:m:p:h")) != -1) {
+        switch (opt) {
+        case 'c': max_cpus = atoi(optarg); break;
+        case 'i': interval_us = atoi(optarg); break;
+        case 'd': duration = atoi(optarg); break;
+        case 'w': window_s = atoi(optarg); break;
+        case 'm': max_us = atoi(optarg); break;
+        case 'p': rt_priority = atoi(optarg); break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (max_cpus < 0 || interval_us < 1 || duration < 0 || window_s < 0 ||
+        max_us < 1 || rt_priority < 0 || rt_priority > 99) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = handle_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    // One probe per CPU this process may run on (respects taskset/cpusets)
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) < 0) {
+        perror("sched_getaffinity");
+        return 1;
+    }
+    probes = calloc(CPU_COUNT(&allowed), sizeof(probe_t));
+    if (!probes) {
+        perror("Failed to allocate probes");
+        return 1;
+    }
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (!CPU_ISSET(cpu, &allowed))
+            continue;
+        if (max_cpus > 0 && num_cpus >= max_cpus)
+            break;
+        probes[num_cpus++].cpu = cpu;
+    }
+
+    fprintf(stderr, "=== Wakeup Latency Probe ===\n");
+    fprintf(stderr, "PID: %d\n", getpid());
+    fprintf(stderr, "CPUs: %d, interval: %d us, policy: %s\n", num_cpus, interval_us,
+            rt_priority > 0 ? "SCHED_FIFO" : "SCHED_OTHER");
+    fprintf(stderr, "Use: cat /proc/sched_stats to monitor scheduler behavior\n\n");
+
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, PROBE_STACK_SIZE);
+
+    start = stamp_now();
+    for (int i = 0; i < num_cpus; i++) {
+        pthread_mutex_init(&probes[i].lock, NULL);
+        if (hist_init(&probes[i].window) < 0 || hist_init(&probes[i].spare) < 0 ||
+            hist_init(&probes[i].total) < 0) {
+            perror("Failed to allocate histograms");
+            return 1;
+        }
+        if (pthread_create(&probes[i].thread, &attr, probe_thread, &probes[i]) != 0) {
+            perror("Failed to create probe thread");
+            return 1;
+        }
+    }
+    pthread_attr_destroy(&attr);
+
+    // Lock what exists now (histograms, thread stacks) to avoid page faults in
+    // the measurement loop. MCL_FUTURE would make every later allocation count
+    // against RLIMIT_MEMLOCK, and probing works without locking, so only warn.
+    if (mlockall(MCL_CURRENT) < 0)
+        fprintf(stderr, "Warning: mlockall failed, running unlocked: %s\n", strerror(errno));
+
+    // Main thread only wakes once per second to flush windows
+    window_start = start;
+    while (keep_running) {
+        stamp_t now;
+
+        sleep(1);
+        now = stamp_now();
+
+        if (window_s > 0 && now.mono - window_start.mono >= window_s * 1000000000ULL) {
+            for (int i = 0; i < num_cpus; i++) {
+                histogram_t full;
+
+                // Swap under the lock, print outside it
+                pthread_mutex_lock(&probes[i].lock);
+                full = probes[i].window;
+                probes[i].window = probes[i].spare;
+                probes[i].spare = full;
+                pthread_mutex_unlock(&probes[i].lock);
+
+                print_record("window", &probes[i], &probes[i].spare, window_start, now);
+                hist_reset(&probes[i].spare);
+            }
+            fflush(stdout);
+            window_start = now;
+        }
+
+        if (duration > 0 && now.mono - start.mono >= duration * 1000000000ULL)
+            keep_running = 0;
+    }
+
+    for (int i = 0; i < num_cpus; i++)
+        pthread_join(probes[i].thread, NULL);
+    end = stamp_now();
+
+    for (int i = 0; i < num_cpus; i++) {
+        print_record("summary", &probes[i], &probes[i].total, start, end);
+        free(probes[i].window.buckets);
+        free(probes[i].spare.buckets);
+        free(probes[i].total.buckets);
+    }
+
+    free(probes);
+    return 0;
+}
@@ -0,0 +1,129 @@
+#!/bin/bash
+
+# run_benchmark.sh - Monitor overhead benchmark sweep
+# Runs bench_monitor with the module unloaded and loaded, across task
+# counts, threads per task and sampling intervals, and writes one CSV row
+# per run.
+#
+# Override any setting from the environment, e.g.:
+#   TASK_COUNTS="1000 5000" INTERVALS="100 1000" ./run_benchmark.sh
+# To benchmark a different table size, rebuild first:
+#   make clean && make HASH_BITS=14 && HASH_BITS=14 ./run_benchmark.sh
+# The hash_bits column is what the loaded module reports; if HASH_BITS is
+# set and the module was built with a different size, the sweep stops.
+
+set -e  # Exit on error
+
+BLUE='\033[0;34m'
+GREEN='\033[0;32m'
+YELLOW='\033[1;33m'
+RED='\033[0;31m'
+NC='\033[0m' # No Color
+
+# Configuration
+TASK_COUNTS=${TASK_COUNTS:-"1000 10000 100000"}
+ACTIVE_PERCENT=${ACTIVE_PERCENT:-"0 10"}      # Share of tasks that wake every 10 ms
+THREADS_PER_TASK=${THREADS_PER_TASK:-"0"}     # Extra idle threads per task, e.g. "0 4 16"
+INTERVALS=${INTERVALS:-"100 500 1000"}        # sampling_interval_ms values
+WORKERS=${WORKERS:-4}
+BENCH_DURATION=${BENCH_DURATION:-10}
+REPEATS=${REPEATS:-3}
+HASH_BITS=${HASH_BITS:-}                      # Expected table size; empty accepts any
+OUTPUT_DIR="results"
+TIMESTAMP=$(date +%Y%m%d_%H%M%S)
+OUTPUT_FILE="$OUTPUT_DIR/benchmark_${TIMESTAMP}.csv"
+
+print_step() {
+    echo -e "${GREEN}[STEP]${NC} $1"
+}
+
+print_info() {
+    echo -e "${YELLOW}[INFO]${NC} $1"
+}
+
+print_error() {
+    echo -e "${RED}[ERROR]${NC} $1"
+}
+
+unload_module() {
+    if lsmod | grep -q "sched_monitor"; then
+        sudo rmmod sched_monitor
+    fi
+}
+
+# Table size the module was built with, from its read-only parameter
+module_hash_bits() {
+    cat /sys/module/sched_monitor/parameters/hash_bits
+}
+
+# Run one benchmark and prefix its CSV row with the module configuration
+run_bench() {
+    local module_state=$1
+    local interval=$2
+    local idle=$3
+    local active=$4
+    local threads=$5
+    local row
+
+    row=$(./bench_monitor -i "$idle" -a "$active" -t "$threads" -w "$WORKERS" -d "$BENCH_DURATION")
+    echo "${module_state},${interval},${MODULE_HASH_BITS},${row}" >> "$OUTPUT_FILE"
+    print_info "module=${module_state} interval=${interval}ms -> ${row}"
+}
+
+echo -e "${BLUE}========================================${NC}"
+echo -e "${BLUE}Scheduler Monitor Overhead Benchmark${NC}"
+echo -e "${BLUE}========================================${NC}"
+echo ""
+
+if [ ! -f "sched_monitor.ko" ]; then
+    print_error "Kernel module not built. Run 'make' first."
+    exit 1
+fi
+
+if [ ! -f "bench_monitor" ]; then
+    print_error "Benchmark not built. Run 'make bench' first."
+    exit 1
+fi
+
+unload_module
+
+# Label rows with the table size of the .ko actually being loaded
+sudo insmod sched_monitor.ko
+MODULE_HASH_BITS=$(module_hash_bits)
+unload_module
+if [ -n "$HASH_BITS" ] && [ "$HASH_BITS" != "$MODULE_HASH_BITS" ]; then
+    print_error "sched_monitor.ko was built with HASH_BITS=$MODULE_HASH_BITS, not $HASH_BITS."
+    print_error "Rebuild with 'make clean && make HASH_BITS=$HASH_BITS'."
+    exit 1
+fi
+print_info "Module hash table: 2^${MODULE_HASH_BITS} buckets"
+
+mkdir -p "$OUTPUT_DIR"
+echo "module,sampling_interval_ms,hash_bits,$(./bench_monitor -H)" > "$OUTPUT_FILE"
+
+for tasks in $TASK_COUNTS; do
+    for pct in $ACTIVE_PERCENT; do
+        active=$((tasks * pct / 100))
+        idle=$((tasks - active))
+
+        for threads in $THREADS_PER_TASK; do
+            print_step "Tasks: $tasks ($idle idle, $active active), $threads extra threads each"
+
+            for run in $(seq 1 "$REPEATS"); do
+                # Reference: module not loaded
+                run_bench unloaded 0 "$idle" "$active" "$threads"
+
+                for interval in $INTERVALS; do
+                    sudo insmod sched_monitor.ko sampling_interval_ms="$interval"
+                    run_bench loaded "$interval" "$idle" "$active" "$threads"
+                    unload_module
+                done
+            done
+        done
+    done
+done
+
+echo ""
+echo -e "${GREEN}Benchmark complete: $OUTPUT_FILE${NC}"
+echo "Compare ops_per_sec and rtt_p99_us between 'loaded' and 'unloaded' rows"
+echo "with the same task counts to get the monitor's overhead."
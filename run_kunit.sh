@@ -0,0 +1,153 @@
+#!/bin/bash
+
+# run_kunit.sh - Run the module's KUnit suite in a headless QEMU guest
+# Builds an x86_64 guest kernel with the options in .kunitconfig, builds
+# sched_monitor.ko against it with KUNIT=1, boots the guest from an
+# initramfs that loads and unloads the module, and parses the KTAP results
+# from the serial console. Exits non-zero unless the suite passes and the
+# kernel logged no BUG, WARNING or lockdep report.
+#
+# Usage:
+#   ./run_kunit.sh /path/to/linux          # configure and build the guest kernel first
+#   KDIR=/path/to/build ./run_kunit.sh     # reuse a tree already built with .kunitconfig
+# Needs qemu-system-x86_64 and a statically linked busybox. Override from
+# the environment: SMP (vCPUs, default 2; SMP=1 covers the single-CPU
+# case), MEM (MiB), TIMEOUT (seconds), BUSYBOX, QEMU.
+
+set -e  # Exit on error
+
+BLUE='\033[0;34m'
+GREEN='\033[0;32m'
+RED='\033[0;31m'
+NC='\033[0m' # No Color
+
+# Configuration
+KSRC=$1
+KDIR=${KDIR:-$PWD/_kunit_build/linux}
+SMP=${SMP:-2}
+MEM=${MEM:-1024}
+TIMEOUT=${TIMEOUT:-900}                       # TCG without KVM is slow at 100k tasks
+BUSYBOX=${BUSYBOX:-$(command -v busybox || true)}
+QEMU=${QEMU:-qemu-system-x86_64}
+WORK="$PWD/_kunit_build/guest"
+OUTPUT_DIR="results"
+TIMESTAMP=$(date +%Y%m%d_%H%M%S)
+LOG_FILE="$OUTPUT_DIR/kunit_${TIMESTAMP}.log"
+
+print_step() {
+    echo -e "${GREEN}[STEP]${NC} $1"
+}
+
+print_error() {
+    echo -e "${RED}[ERROR]${NC} $1"
+}
+
+# Print the sched_monitor suite from a console log. Exit status: 0 if the
+# suite reported ok, 1 if not ok, 2 if its result line never appeared.
+parse_ktap() {
+    awk '
+        { sub(/\r$/, ""); sub(/^\[[^]]*\] /, ""); line = $0; sub(/^[ \t]+/, "") }
+        /^# Subtest: sched_monitor$/ { in_suite = 1 }
+        !in_suite { next }
+        { print line }
+        /^(not )?ok [0-9]+ sched_monitor( |$)/ { result = ($1 == "ok") ? 0 : 1; exit }
+        END { exit (result == "" ? 2 : result) }
+    ' "$1"
+}
+
+echo -e "${BLUE}========================================${NC}"
+echo -e "${BLUE}Scheduler Monitor KUnit Suite (QEMU)${NC}"
+echo -e "${BLUE}========================================${NC}"
+echo ""
+
+if ! command -v "$QEMU" > /dev/null; then
+    print_error "$QEMU not found."
+    exit 1
+fi
+
+if [ -z "$BUSYBOX" ] || ldd "$BUSYBOX" > /dev/null 2>&1; then
+    print_error "Need a statically linked busybox; set BUSYBOX=/path/to/busybox."
+    exit 1
+fi
+
+# Guest kernel: defconfig plus .kunitconfig, built once and reused
+if [ ! -f "$KDIR/arch/x86/boot/bzImage" ]; then
+    if [ -z "$KSRC" ]; then
+        print_error "No kernel at $KDIR; pass a kernel source tree: $0 /path/to/linux"
+        exit 1
+    fi
+    print_step "Building guest kernel in $KDIR"
+    mkdir -p "$KDIR"
+    make -C "$KSRC" O="$KDIR" ARCH=x86_64 x86_64_defconfig
+    "$KSRC/scripts/kconfig/merge_config.sh" -m -O "$KDIR" "$KDIR/.config" .kunitconfig
+    make -C "$KSRC" O="$KDIR" ARCH=x86_64 olddefconfig
+    make -C "$KSRC" O="$KDIR" ARCH=x86_64 -j"$(nproc)"
+fi
+
+if ! grep -q "^CONFIG_KUNIT=[ym]" "$KDIR/.config"; then
+    print_error "$KDIR was not built with CONFIG_KUNIT; see .kunitconfig."
+    exit 1
+fi
+
+print_step "Building sched_monitor.ko with KUNIT=1"
+make KDIR="$KDIR" KUNIT=1
+
+# Initramfs: busybox, the module, and an init that loads it and powers off
+print_step "Creating initramfs"
+mkdir -p "$WORK" "$OUTPUT_DIR"
+cat > "$WORK/init" << 'EOF'
+#!/bin/sh
+/bin/busybox --install -s /bin
+mount -t proc proc /proc
+mount -t sysfs sysfs /sys
+[ -f /kunit.ko ] && insmod /kunit.ko
+insmod /sched_monitor.ko || echo "run_kunit: insmod sched_monitor.ko failed"
+rmmod sched_monitor || echo "run_kunit: rmmod sched_monitor failed"
+poweroff -f
+EOF
+{
+    echo "dir /bin 755 0 0"
+    echo "dir /dev 755 0 0"
+    echo "dir /proc 755 0 0"
+    echo "dir /sys 755 0 0"
+    echo "nod /dev/console 600 0 0 c 5 1"
+    echo "file /bin/busybox $BUSYBOX 755 0 0"
+    echo "slink /bin/sh busybox 777 0 0"
+    echo "file /init $WORK/init 755 0 0"
+    echo "file /sched_monitor.ko $PWD/sched_monitor.ko 644 0 0"
+    # CONFIG_KUNIT=m: the framework has to be loaded first
+    if [ -f "$KDIR/lib/kunit/kunit.ko" ]; then
+        echo "file /kunit.ko $KDIR/lib/kunit/kunit.ko 644 0 0"
+    fi
+} > "$WORK/initramfs.list"
+"$KDIR/usr/gen_init_cpio" "$WORK/initramfs.list" | gzip > "$WORK/initramfs.cpio.gz"
+
+ACCEL="tcg"
+if [ -w /dev/kvm ]; then
+    ACCEL="kvm"
+fi
+
+print_step "Booting guest ($SMP vCPU, $ACCEL), log: $LOG_FILE"
+timeout "$TIMEOUT" "$QEMU" -accel "$ACCEL" -m "$MEM" -smp "$SMP" \
+    -nographic -no-reboot \
+    -kernel "$KDIR/arch/x86/boot/bzImage" \
+    -initrd "$WORK/initramfs.cpio.gz" \
+    -append "console=ttyS0 panic=-1 loglevel=7" > "$LOG_FILE" 2>&1 || true
+
+echo ""
+status=0
+parse_ktap "$LOG_FILE" || status=$?
+
+if grep -qE "BUG:|WARNING:|Oops|possible recursive locking|inconsistent lock state|Kernel panic" "$LOG_FILE"; then
+    print_error "Kernel reported problems:"
+    grep -E "BUG:|WARNING:|Oops|possible recursive locking|inconsistent lock state|Kernel panic" "$LOG_FILE"
+    [ "$status" -eq 0 ] && status=1
+fi
+
+echo ""
+case $status in
+    0) echo -e "${GREEN}KUnit suite passed${NC}" ;;
+    2) print_error "No sched_monitor results in $LOG_FILE (module failed to load, or timeout)" ;;
+    *) print_error "KUnit suite failed; full console log: $LOG_FILE" ;;
+esac
+exit "$status"
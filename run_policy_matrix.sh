@@ -0,0 +1,139 @@
+#!/bin/bash
+
+# run_policy_matrix.sh - A/B scheduling policy comparison
+# Repeats one workload_gen profile under every combination of scheduling
+# policy, nice level and CPU affinity, capturing module statistics and
+# workload results for each run. compare_policies.py then reports means,
+# confidence intervals and significant differences against the baseline
+# (the first policy/nice/affinity in each list).
+#
+# Override any setting from the environment, e.g.:
+#   POLICIES="other batch" NICES="0 5" REPEATS=10 ./run_policy_matrix.sh
+
+set -e  # Exit on error
+
+BLUE='\033[0;34m'
+GREEN='\033[0;32m'
+YELLOW='\033[1;33m'
+RED='\033[0;31m'
+NC='\033[0m' # No Color
+
+# Configuration
+PROFILE=${PROFILE:-profiles/mixed.prof}
+POLICIES=${POLICIES:-"other batch idle fifo"}
+NICES=${NICES:-"0 10"}
+AFFINITIES=${AFFINITIES:-"all"}             # taskset CPU lists, "all" = no pinning
+REPEATS=${REPEATS:-5}
+RUN_DURATION=${RUN_DURATION:-10}
+FIFO_PRIORITY=${FIFO_PRIORITY:-10}
+OUTPUT_DIR="results"
+TIMESTAMP=$(date +%Y%m%d_%H%M%S)
+RUN_DIR="$OUTPUT_DIR/policy_${TIMESTAMP}"
+MANIFEST="$RUN_DIR/manifest.csv"
+
+print_step() {
+    echo -e "${GREEN}[STEP]${NC} $1"
+}
+
+print_info() {
+    echo -e "${YELLOW}[INFO]${NC} $1"
+}
+
+print_error() {
+    echo -e "${RED}[ERROR]${NC} $1"
+}
+
+# Snapshot module statistics (empty file if the module is not loaded)
+snapshot() {
+    if [ -r /proc/sched_stats ]; then
+        cat /proc/sched_stats > "$1"
+    else
+        : > "$1"
+    fi
+}
+
+# Build the command prefix for one policy/nice/affinity combination
+launcher() {
+    local policy=$1
+    local nice=$2
+    local cpus=$3
+    local cmd=""
+
+    case "$policy" in
+        other) cmd="chrt --other 0" ;;
+        batch) cmd="chrt --batch 0" ;;
+        idle)  cmd="chrt --idle 0" ;;
+        fifo)  cmd="sudo chrt --fifo $FIFO_PRIORITY" ;;
+        rr)    cmd="sudo chrt --rr $FIFO_PRIORITY" ;;
+        *)     print_error "Unknown policy: $policy"; exit 1 ;;
+    esac
+
+    if [ "$nice" -lt 0 ] && [[ "$cmd" != sudo* ]]; then
+        cmd="sudo $cmd"
+    fi
+    cmd="$cmd nice -n $nice"
+
+    if [ "$cpus" != "all" ]; then
+        cmd="$cmd taskset -c $cpus"
+    fi
+    echo "$cmd"
+}
+
+echo -e "${BLUE}========================================${NC}"
+echo -e "${BLUE}Scheduling Policy A/B Comparison${NC}"
+echo -e "${BLUE}========================================${NC}"
+echo ""
+
+if [ ! -f "workload_gen" ]; then
+    print_error "workload_gen not built. Run 'make tests' first."
+    exit 1
+fi
+
+if [ ! -f "$PROFILE" ]; then
+    print_error "Profile not found: $PROFILE"
+    exit 1
+fi
+
+if [ ! -r /proc/sched_stats ]; then
+    print_info "sched_monitor not loaded - module statistics will be empty"
+    print_info "Load it with: sudo insmod sched_monitor.ko"
+fi
+
+mkdir -p "$RUN_DIR"
+cp "$PROFILE" "$RUN_DIR/"
+echo "run,repeat,policy,nice,affinity,result,before,after" > "$MANIFEST"
+
+# Repeats form the outer loop so slow drift (thermal, background jobs)
+# spreads evenly across configurations instead of biasing one of them
+run=0
+for rep in $(seq 1 "$REPEATS"); do
+    print_step "Repeat $rep of $REPEATS"
+    for policy in $POLICIES; do
+        for nice in $NICES; do
+            for cpus in $AFFINITIES; do
+                run=$((run + 1))
+                tag="run${run}_${policy}_nice${nice}_cpus${cpus//[,-]/_}"
+                cmd=$(launcher "$policy" "$nice" "$cpus")
+
+                print_info "$tag: $cmd ./workload_gen"
+                snapshot "$RUN_DIR/${tag}_before.txt"
+                $cmd ./workload_gen -p "$PROFILE" -d "$RUN_DURATION" \
+                    -o "$RUN_DIR/${tag}.json" 2> "$RUN_DIR/${tag}.log"
+                snapshot "$RUN_DIR/${tag}_after.txt"
+
+                echo "${run},${rep},${policy},${nice},${cpus},${tag}.json,${tag}_before.txt,${tag}_after.txt" >> "$MANIFEST"
+                sleep 1
+            done
+        done
+    done
+done
+
+echo ""
+echo -e "${GREEN}Runs complete: $RUN_DIR${NC}"
+echo ""
+
+if command -v python3 &> /dev/null; then
+    python3 compare_policies.py "$RUN_DIR" | tee "$RUN_DIR/report.txt"
+else
+    echo "To analyze results, run: python3 compare_policies.py $RUN_DIR"
+fi
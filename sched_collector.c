@@ -0,0 +1,328 @@
+/*
+ * sched_collector.c - Streaming collector for sched_monitor statistics
+ *
+ * Replaces the `cat /proc/sched_stats > results/...txt` snapshots: reads the
+ * module at a fixed rate on absolute deadlines and appends each sample to a
+ * compact .sts time-series file (see sched_ts.h), with a seekable index
+ * alongside it. Unchanged rows cost nothing, so long high-rate captures stay
+ * small. Read the output with sched_ts_dump or the sched_ts.c reader API.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+
+#include "sched_ts.h"
+
+#define DEFAULT_INTERVAL_MS 1000
+#define DEFAULT_KEYFRAME_EVERY 600
+#define DEFAULT_PROC_PATH "/proc/sched_stats"
+#define STATS_TRAILER "NOTE: Priority values"   // First line after the process table
+#define ROW_PID_WIDTH 8                         // "%-8d " in the module's row format
+#define ROW_COMM_WIDTH 20                       // "%-20s "
+#define ROW_COMM_MAX 15                         // TASK_COMM_LEN - 1
+#define ROW_COUNTERS_OFFSET (ROW_PID_WIDTH + 1 + ROW_COMM_WIDTH + 1)
+
+volatile sig_atomic_t keep_running = 1;
+
+static void handle_signal(int sig) {
+    (void)sig;
+    keep_running = 0;
+}
+
+/*
+ * Read the whole proc file into a growing buffer. Returns length or -1.
+ */
+static ssize_t read_proc(const char *path, char **buf, size_t *cap) {
+    size_t len = 0;
+    int fd = open(path, O_RDONLY);
+
+    if (fd < 0)
+        return -1;
+
+    for (;;) {
+        ssize_t n;
+
+        if (len + 1 >= *cap) {
+            size_t ncap = *cap ? *cap * 2 : 1 << 20;
+            char *nbuf = realloc(*buf, ncap);
+            if (!nbuf) {
+                close(fd);
+                return -1;
+            }
+            *buf = nbuf;
+            *cap = ncap;
+        }
+        n = read(fd, *buf + len, *cap - len - 1);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            close(fd);
+            return -1;
+        }
+        if (n == 0)
+            break;
+        len += n;
+    }
+
+    close(fd);
+    (*buf)[len] = '\0';
+    return len;
+}
+
+static int header_value(const char *line, const char *key, int64_t *out) {
+    size_t klen = strlen(key);
+
+    if (strncmp(line, key, klen) != 0)
+        return 0;
+    *out = strtoll(line + klen, NULL, 10);
+    return 1;
+}
+
+/*
+ * Parse one table row. The module prints "%-8d %-20s " before the six
+ * numeric columns and a task name is at most 15 chars, so the pid, comm
+ * and counters always sit at fixed offsets. Lines that do not match that
+ * layout exactly (fragments of a comm containing a newline) are rejected.
+ */
+static int parse_row(char *line, sts_row_t *row) {
+    size_t len = strlen(line);
+    char *comm_end, *p;
+    long pid;
+
+    if (len <= ROW_COUNTERS_OFFSET || !isdigit((unsigned char)line[0]))
+        return 0;
+    pid = strtol(line, &p, 10);
+    if (pid <= 0 || p > line + ROW_PID_WIDTH)
+        return 0;
+    while (p < line + ROW_PID_WIDTH + 1)
+        if (*p++ != ' ')
+            return 0;
+
+    // Comm is padded to ROW_COMM_WIDTH, so its tail and the separator are blank
+    comm_end = line + ROW_COUNTERS_OFFSET - 1;
+    for (p = line + ROW_PID_WIDTH + 1 + ROW_COMM_MAX; p <= comm_end; p++)
+        if (*p != ' ')
+            return 0;
+    while (comm_end > line + ROW_PID_WIDTH + 1 && comm_end[-1] == ' ')
+        comm_end--;
+
+    p = line + ROW_COUNTERS_OFFSET;
+    if (isspace((unsigned char)*p))
+        return 0;
+    for (int f = 0; f < STS_NUM_COUNTERS; f++) {
+        char *num_end;
+        if (f > 0 && !isspace((unsigned char)*p))
+            return 0;
+        row->counters[f] = strtoll(p, &num_end, 10);
+        if (num_end == p)
+            return 0;
+        p = num_end;
+    }
+    while (isspace((unsigned char)*p))
+        p++;
+    if (*p != '\0')
+        return 0;
+
+    row->pid = pid;
+    memset(row->comm, 0, sizeof(row->comm));
+    memcpy(row->comm, line + ROW_PID_WIDTH + 1, (size_t)(comm_end - (line + ROW_PID_WIDTH + 1)));
+    return 1;
+}
+
+/*
+ * Drop every row of a pid that appears more than once in a sorted
+ * snapshot; the module never prints a pid twice, so at most one of them
+ * is genuine and there is no telling which. Returns the new row count.
+ */
+static size_t drop_duplicate_pids(sts_row_t *rows, size_t nrows) {
+    size_t out = 0, i = 0;
+
+    while (i < nrows) {
+        size_t j = i + 1;
+        while (j < nrows && rows[j].pid == rows[i].pid)
+            j++;
+        if (j == i + 1)
+            rows[out++] = rows[i];
+        i = j;
+    }
+    return out;
+}
+
+/*
+ * Parse a /proc/sched_stats dump into a snapshot. Returns 0 or -1.
+ */
+int parse_stats(char *text, sts_snapshot_t *snap, size_t *rows_cap) {
+    char *save = NULL;
+    int in_table = 0, skip_next = 0;
+
+    snap->nrows = 0;
+    memset(snap->globals, 0, sizeof(snap->globals));
+
+    for (char *line = strtok_r(text, "\n", &save); line; line = strtok_r(NULL, "\n", &save)) {
+        if (!in_table) {
+            header_value(line, "Total Samples Taken:", &snap->globals[STS_SAMPLES_TAKEN]);
+            header_value(line, "Total Processes Tracked:", &snap->globals[STS_PROCESSES_TRACKED]);
+            header_value(line, "Total Context Switches:", &snap->globals[STS_GLOBAL_CS]);
+            if (strncmp(line, "---", 3) == 0)
+                in_table = 1;
+            continue;
+        }
+
+        if (snap->nrows == *rows_cap) {
+            size_t ncap = *rows_cap ? *rows_cap * 2 : 4096;
+            sts_row_t *rows = realloc(snap->rows, ncap * sizeof(*rows));
+            if (!rows)
+                return -1;
+            snap->rows = rows;
+            *rows_cap = ncap;
+        }
+        // The trailer is longer than a task name (15 chars), so a comm with
+        // embedded newlines cannot fake it
+        if (strncmp(line, STATS_TRAILER, strlen(STATS_TRAILER)) == 0)
+            break;
+        // A row split by a newline in comm is skipped whole: the fragment
+        // fails to parse and the line after it is its tail, not a new row
+        if (skip_next) {
+            skip_next = 0;
+            continue;
+        }
+        if (parse_row(line, &snap->rows[snap->nrows]))
+            snap->nrows++;
+        else
+            skip_next = 1;
+    }
+
+    sts_sort_rows(snap->rows, snap->nrows);
+    snap->nrows = drop_duplicate_pids(snap->rows, snap->nrows);
+    return in_table ? 0 : -1;
+}
+
+void usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s [-o output.sts] [-i interval_ms] [-n samples] [-k keyframe_every] [-s source] [-D]\n"
+            "  -o  output file; an index is written to <output>.idx\n"
+            "      (default: results/sched_<timestamp>.sts)\n"
+            "  -i  sampling interval in milliseconds (default: %d)\n"
+            "  -n  stop after this many samples (default: run until SIGINT/SIGTERM)\n"
+            "  -k  write a full keyframe every N samples; seek granularity (default: %d)\n"
+            "  -s  statistics source (default: %s)\n"
+            "  -D  detach and run as a daemon\n",
+            prog, DEFAULT_INTERVAL_MS, DEFAULT_KEYFRAME_EVERY, DEFAULT_PROC_PATH);
+}
+
+int main(int argc, char *argv[]) {
+    unsigned interval_ms = DEFAULT_INTERVAL_MS;
+    unsigned keyframe_every = DEFAULT_KEYFRAME_EVERY;
+    const char *source = DEFAULT_PROC_PATH;
+    char default_output[256];
+    const char *output = NULL;
+    long max_samples = 0, samples = 0;
+    int daemonize = 0;
+    sts_snapshot_t snap = {0};
+    size_t rows_cap = 0;
+    char *text = NULL;
+    size_t text_cap = 0;
+    struct timespec next;
+    struct sigaction sa;
+    sts_writer_t *writer;
+    int opt;
+
+    // Parse arguments
+    while ((opt = getopt(argc, argv, "o:i:n:k:s:Dh")) != -1) {
+        switch (opt) {
+        case 'o': output = optarg; break;
+        case 'i': interval_ms = strtoul(optarg, NULL, 10); break;
+        case 'n': max_samples = atol(optarg); break;
+        case 'k': keyframe_every = strtoul(optarg, NULL, 10); break;
+        case 's': source = optarg; break;
+        case 'D': daemonize = 1; break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (interval_ms < 1 || keyframe_every < 1 || max_samples < 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (!output) {
+        time_t now = time(NULL);
+        char stamp[32];
+        strftime(stamp, sizeof(stamp), "%Y%m%d_%H%M%S", localtime(&now));
+        snprintf(default_output, sizeof(default_output), "results/sched_%s.sts", stamp);
+        output = default_output;
+    }
+
+    if (access(source, R_OK) < 0) {
+        fprintf(stderr, "Cannot read %s: %s\n", source, strerror(errno));
+        fprintf(stderr, "Is the module loaded? Try: sudo insmod sched_monitor.ko\n");
+        return 1;
+    }
+
+    writer = sts_writer_open(output, interval_ms, keyframe_every);
+    if (!writer) {
+        fprintf(stderr, "Cannot create %s: %s\n", output, strerror(errno));
+        return 1;
+    }
+
+    fprintf(stderr, "Collecting %s every %u ms into %s\n", source, interval_ms, output);
+    if (daemonize && daemon(1, 0) < 0) {
+        perror("daemon");
+        sts_writer_close(writer);
+        return 1;
+    }
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = handle_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    while (keep_running && (max_samples == 0 || samples < max_samples)) {
+        struct timespec now;
+
+        if (read_proc(source, &text, &text_cap) < 0) {
+            fprintf(stderr, "Read %s failed: %s\n", source, strerror(errno));
+            break;
+        }
+        clock_gettime(CLOCK_REALTIME, &now);
+        snap.timestamp_ns = (int64_t)now.tv_sec * 1000000000LL + now.tv_nsec;
+
+        if (parse_stats(text, &snap, &rows_cap) < 0) {
+            fprintf(stderr, "Unrecognized format in %s\n", source);
+            break;
+        }
+        if (sts_writer_append(writer, &snap) < 0) {
+            fprintf(stderr, "Write %s failed: %s\n", output, strerror(errno));
+            break;
+        }
+        samples++;
+
+        // Absolute deadlines: no drift from read/parse time
+        next.tv_sec += interval_ms / 1000;
+        next.tv_nsec += (interval_ms % 1000) * 1000000L;
+        if (next.tv_nsec >= 1000000000L) {
+            next.tv_nsec -= 1000000000L;
+            next.tv_sec++;
+        }
+        if (keep_running && (max_samples == 0 || samples < max_samples))
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+    }
+
+    fprintf(stderr, "Wrote %ld samples, %llu bytes to %s\n",
+            samples, (unsigned long long)sts_writer_bytes(writer), output);
+
+    sts_writer_close(writer);
+    free(snap.rows);
+    free(text);
+    return 0;
+}
@@ -5,6 +5,7 @@
  * - Tracking context switches
  * - Measuring process run times and wait times
  * - Collecting scheduler statistics
+ * - Rolling them up per SMT core, LLC domain and NUMA node
  * - Exposing data through /proc interface
  */
 
@@ -20,10 +21,24 @@
 #include <linux/hashtable.h>
 #include <linux/slab.h>
 #include <linux/uaccess.h>
+#include <linux/cpumask.h>
+#include <linux/math64.h>
+#include <linux/string.h>
+#include <linux/topology.h>
+#include <linux/cacheinfo.h>
+#include <linux/kernel_stat.h>
+#ifdef SCHED_MONITOR_KUNIT
+#include <linux/kthread.h>
+#include <linux/completion.h>
+#include <kunit/test.h>
+#endif
 
 #define MODULE_NAME "sched_monitor"
 #define PROC_NAME "sched_stats"
-#define PROCESS_HASH_BITS 10
+#define TOPO_PROC_NAME "sched_topology"
+#ifndef PROCESS_HASH_BITS
+#define PROCESS_HASH_BITS 10    /* Override with: make HASH_BITS=<n> */
+#endif
 #define PROCESS_HASH_SIZE (1 << PROCESS_HASH_BITS)
 
 MODULE_LICENSE("GPL");
@@ -42,6 +57,7 @@ struct process_stats {
     u64 last_seen_ns;
     int priority;
     int nice_value;
+    int last_cpu;
     struct hlist_node hash_node;
 };
 
@@ -57,8 +73,9 @@ struct global_stats {
 static DEFINE_HASHTABLE(process_table, PROCESS_HASH_BITS);
 static DEFINE_SPINLOCK(stats_lock);
 
-/* Proc filesystem entry */
+/* Proc filesystem entries */
 static struct proc_dir_entry *proc_entry;
+static struct proc_dir_entry *topo_proc_entry;
 
 /* Timer for periodic sampling */
 static struct timer_list sampling_timer;
@@ -67,95 +84,432 @@ static unsigned int sampling_interval_ms = 1000; // 1 second
 module_param(sampling_interval_ms, uint, 0644);
 MODULE_PARM_DESC(sampling_interval_ms, "Sampling interval in milliseconds (default: 1000)");
 
+/* Table size the module was built with; reported so benchmarks can label runs */
+static unsigned int hash_bits = PROCESS_HASH_BITS;
+
+static int hash_bits_set(const char *val, const struct kernel_param *kp)
+{
+    return -EPERM;  /* Fixed at build time: make HASH_BITS=<n> */
+}
+
+static const struct kernel_param_ops hash_bits_ops = {
+    .set = hash_bits_set,
+    .get = param_get_uint,
+};
+
+module_param_cb(hash_bits, &hash_bits_ops, &hash_bits, 0444);
+MODULE_PARM_DESC(hash_bits, "log2 of the process hash table size (read-only, set at build time)");
+
 /*
- * Find or create process statistics entry
+ * Topology rollups: every CPU maps to one SMT core, one LLC domain and one
+ * NUMA node. The maps are built once at load time; counters are updated
+ * under stats_lock as samples arrive.
  */
-static struct process_stats* get_process_stats(struct task_struct *task)
+enum topo_level {
+    TOPO_CORE,
+    TOPO_LLC,
+    TOPO_NODE,
+    TOPO_NR_LEVELS
+};
+
+static const char * const topo_level_names[TOPO_NR_LEVELS] = { "core", "llc", "node" };
+
+struct topo_domain {
+    unsigned int first_cpu;
+    unsigned int nr_cpus;
+    unsigned long context_switches;
+    u64 busy_ns;
+    unsigned long runnable;             /* Runnable threads at the last sample */
+    unsigned long runnable_sum;         /* For the average over all samples */
+    unsigned long migrations_in;
+    unsigned long migrations_out;
+};
+
+struct topo_map {
+    int *cpu_domain;                    /* nr_cpu_ids entries */
+    struct topo_domain *domains;
+    unsigned int nr_domains;
+};
+
+static struct topo_map topo[TOPO_NR_LEVELS];
+static u64 *cpu_busy_prev;              /* Per CPU, busy time at the last sample */
+static unsigned int *cpu_runnable;      /* Per CPU, counted during one sample */
+static unsigned long topo_samples;
+
+#ifndef task_is_running
+#define task_is_running(task) ((task)->state == TASK_RUNNING)
+#endif
+
+/*
+ * LLC domain key: first CPU sharing the highest cache level, or the
+ * package when the architecture does not report cache topology or the
+ * kernel does not export get_cpu_cacheinfo() (see the Makefile)
+ */
+static unsigned int topo_llc_key(unsigned int cpu)
+{
+    unsigned int key;
+#ifdef HAVE_GET_CPU_CACHEINFO
+    struct cpu_cacheinfo *ci = get_cpu_cacheinfo(cpu);
+    struct cacheinfo *llc = NULL;
+    unsigned int i;
+    
+    for (i = 0; ci && ci->info_list && i < ci->num_leaves; i++) {
+        if (!llc || ci->info_list[i].level > llc->level)
+            llc = &ci->info_list[i];
+    }
+    if (llc) {
+        key = cpumask_first(&llc->shared_cpu_map);
+        if (key < nr_cpu_ids)
+            return key;
+    }
+#endif
+    
+    key = cpumask_first(topology_core_cpumask(cpu));
+    return key < nr_cpu_ids ? key : cpu;
+}
+
+static unsigned int topo_key(enum topo_level level, unsigned int cpu)
+{
+    unsigned int key;
+    
+    switch (level) {
+    case TOPO_CORE:
+        key = cpumask_first(topology_sibling_cpumask(cpu));
+        return key < nr_cpu_ids ? key : cpu;
+    case TOPO_LLC:
+        return topo_llc_key(cpu);
+    default:
+        return cpu_to_node(cpu) < 0 ? 0 : cpu_to_node(cpu);
+    }
+}
+
+/*
+ * Total non-idle time a CPU has accounted, in ns. On nohz_full CPUs the
+ * raw counters only advance at context switches; kcpustat_cpu_fetch()
+ * adds the running task's pending time.
+ */
+static u64 cpu_busy_ns(unsigned int cpu)
+{
+    struct kernel_cpustat kstat;
+    u64 *cpustat = kstat.cpustat;
+    
+    kcpustat_cpu_fetch(&kstat, cpu);
+    return cpustat[CPUTIME_USER] + cpustat[CPUTIME_NICE] + cpustat[CPUTIME_SYSTEM] +
+           cpustat[CPUTIME_IRQ] + cpustat[CPUTIME_SOFTIRQ] + cpustat[CPUTIME_STEAL];
+}
+
+static void topo_free(void)
+{
+    int level;
+    
+    for (level = 0; level < TOPO_NR_LEVELS; level++) {
+        kfree(topo[level].cpu_domain);
+        kfree(topo[level].domains);
+        topo[level].cpu_domain = NULL;
+        topo[level].domains = NULL;
+        topo[level].nr_domains = 0;
+    }
+    kfree(cpu_busy_prev);
+    kfree(cpu_runnable);
+    cpu_busy_prev = NULL;
+    cpu_runnable = NULL;
+}
+
+/*
+ * Zero all rollup counters and start busy time from now
+ */
+static void topo_reset(void)
 {
-    struct process_stats *ps;
-    pid_t pid = task->pid;
     unsigned long flags;
+    unsigned int i;
+    int level, cpu;
     
     spin_lock_irqsave(&stats_lock, flags);
+    for (level = 0; level < TOPO_NR_LEVELS; level++) {
+        for (i = 0; i < topo[level].nr_domains; i++) {
+            struct topo_domain *d = &topo[level].domains[i];
+            unsigned int first_cpu = d->first_cpu, nr_cpus = d->nr_cpus;
+            
+            memset(d, 0, sizeof(*d));
+            d->first_cpu = first_cpu;
+            d->nr_cpus = nr_cpus;
+        }
+    }
+    for_each_possible_cpu(cpu)
+        cpu_busy_prev[cpu] = cpu_busy_ns(cpu);
+    topo_samples = 0;
+    spin_unlock_irqrestore(&stats_lock, flags);
+}
+
+/*
+ * Build the CPU -> domain maps for every level from the current topology
+ */
+static int topo_init(void)
+{
+    unsigned int nr_keys = max_t(unsigned int, nr_cpu_ids, nr_node_ids);
+    int *key_domain;
+    int level, cpu;
     
-    /* Search for existing entry */
-    hash_for_each_possible(process_table, ps, hash_node, pid) {
-        if (ps->pid == pid) {
-            spin_unlock_irqrestore(&stats_lock, flags);
-            return ps;
+    key_domain = kcalloc(nr_keys, sizeof(*key_domain), GFP_KERNEL);
+    cpu_busy_prev = kcalloc(nr_cpu_ids, sizeof(*cpu_busy_prev), GFP_KERNEL);
+    cpu_runnable = kcalloc(nr_cpu_ids, sizeof(*cpu_runnable), GFP_KERNEL);
+    if (!key_domain || !cpu_busy_prev || !cpu_runnable)
+        goto nomem;
+    
+    for (level = 0; level < TOPO_NR_LEVELS; level++) {
+        struct topo_map *map = &topo[level];
+        unsigned int i;
+        
+        map->cpu_domain = kcalloc(nr_cpu_ids, sizeof(*map->cpu_domain), GFP_KERNEL);
+        map->domains = kcalloc(nr_keys, sizeof(*map->domains), GFP_KERNEL);
+        if (!map->cpu_domain || !map->domains)
+            goto nomem;
+        
+        /* Number domains densely in order of their first CPU */
+        for (i = 0; i < nr_keys; i++)
+            key_domain[i] = -1;
+        for_each_possible_cpu(cpu) {
+            unsigned int key = topo_key(level, cpu);
+            
+            if (key_domain[key] < 0) {
+                key_domain[key] = map->nr_domains++;
+                map->domains[key_domain[key]].first_cpu = cpu;
+            }
+            map->cpu_domain[cpu] = key_domain[key];
+            map->domains[key_domain[key]].nr_cpus++;
         }
     }
     
-    /* Create new entry */
-    ps = kmalloc(sizeof(*ps), GFP_ATOMIC);
-    if (!ps) {
-        spin_unlock_irqrestore(&stats_lock, flags);
-        return NULL;
+    kfree(key_domain);
+    topo_reset();
+    return 0;
+    
+nomem:
+    kfree(key_domain);
+    topo_free();
+    return -ENOMEM;
+}
+
+/*
+ * Attribute context switches to the domains of the CPU a task was seen on.
+ * Caller holds stats_lock.
+ */
+static void topo_account_switches(int cpu, unsigned long delta)
+{
+    int level;
+    
+    if (cpu < 0 || !delta)
+        return;
+    for (level = 0; level < TOPO_NR_LEVELS; level++)
+        topo[level].domains[topo[level].cpu_domain[cpu]].context_switches += delta;
+}
+
+/*
+ * Count a task that moved between samples as leaving every domain it is
+ * no longer in. Caller holds stats_lock.
+ */
+static void topo_account_migration(int from, int to)
+{
+    int level;
+    
+    if (from < 0 || to < 0)
+        return;
+    for (level = 0; level < TOPO_NR_LEVELS; level++) {
+        int src = topo[level].cpu_domain[from];
+        int dst = topo[level].cpu_domain[to];
+        
+        if (src != dst) {
+            topo[level].domains[src].migrations_out++;
+            topo[level].domains[dst].migrations_in++;
+        }
     }
+}
+
+/*
+ * Fold per-CPU busy time and runnable counts from one sample into the
+ * rollups
+ */
+static void topo_account_sample(void)
+{
+    unsigned long flags;
+    unsigned int i;
+    int level, cpu;
     
-    ps->pid = pid;
-    get_task_comm(ps->comm, task);
-    ps->context_switches = 0;
-    ps->voluntary_switches = task->nvcsw;
-    ps->involuntary_switches = task->nivcsw;
-    ps->total_runtime_ns = 0;
-    ps->last_seen_ns = ktime_get_ns();
-    ps->priority = task->prio;
-    ps->nice_value = task_nice(task);
+    spin_lock_irqsave(&stats_lock, flags);
     
-    hash_add(process_table, &ps->hash_node, pid);
-    stats.total_processes_tracked++;
+    for (level = 0; level < TOPO_NR_LEVELS; level++) {
+        for (i = 0; i < topo[level].nr_domains; i++)
+            topo[level].domains[i].runnable = 0;
+    }
+    
+    for_each_possible_cpu(cpu) {
+        u64 busy = cpu_busy_ns(cpu);
+        u64 delta = busy > cpu_busy_prev[cpu] ? busy - cpu_busy_prev[cpu] : 0;
+        
+        cpu_busy_prev[cpu] = busy;
+        for (level = 0; level < TOPO_NR_LEVELS; level++) {
+            struct topo_domain *d = &topo[level].domains[topo[level].cpu_domain[cpu]];
+            
+            d->busy_ns += delta;
+            d->runnable += cpu_runnable[cpu];
+            d->runnable_sum += cpu_runnable[cpu];
+        }
+        cpu_runnable[cpu] = 0;
+    }
+    topo_samples++;
     
     spin_unlock_irqrestore(&stats_lock, flags);
-    return ps;
 }
 
+/* Task fields read by the collector, captured once per sample */
+struct task_sample {
+    pid_t pid;
+    int cpu;
+    const char *comm;
+    unsigned long nvcsw;
+    unsigned long nivcsw;
+    int prio;
+    int nice;
+};
+
 /*
- * Update statistics for a process
+ * Find the statistics entry for a pid. Caller holds stats_lock.
  */
-static void update_process_stats(struct task_struct *task)
+static struct process_stats *process_stats_lookup(pid_t pid)
 {
     struct process_stats *ps;
-    unsigned long new_vsw, new_isw;
-    u64 current_time;
-    unsigned long flags;
     
-    if (!task)
-        return;
+    hash_for_each_possible(process_table, ps, hash_node, pid) {
+        if (ps->pid == pid)
+            return ps;
+    }
+    return NULL;
+}
+
+/*
+ * Create the entry for a newly seen task. Switch counters start from the
+ * task's current values, so only switches after this point are counted.
+ * Caller holds stats_lock.
+ */
+static struct process_stats *process_stats_insert(const struct task_sample *s, u64 now)
+{
+    struct process_stats *ps;
     
-    ps = get_process_stats(task);
+    ps = kmalloc(sizeof(*ps), GFP_ATOMIC);
     if (!ps)
-        return;
+        return NULL;
     
-    spin_lock_irqsave(&stats_lock, flags);
+    ps->pid = s->pid;
+    strscpy(ps->comm, s->comm, sizeof(ps->comm));
+    ps->context_switches = 0;
+    ps->voluntary_switches = s->nvcsw;
+    ps->involuntary_switches = s->nivcsw;
+    ps->total_runtime_ns = 0;
+    ps->last_seen_ns = now;
+    ps->priority = s->prio;
+    ps->nice_value = s->nice;
+    ps->last_cpu = s->cpu;
     
-    current_time = ktime_get_ns();
-    new_vsw = task->nvcsw;
-    new_isw = task->nivcsw;
+    hash_add(process_table, &ps->hash_node, s->pid);
+    stats.total_processes_tracked++;
+    return ps;
+}
+
+/*
+ * Fold a new sample into an entry. Caller holds stats_lock.
+ */
+static void process_stats_apply(struct process_stats *ps, const struct task_sample *s, u64 now)
+{
+    unsigned long switches = 0;
     
     /* Update context switch counts */
-    if (new_vsw > ps->voluntary_switches) {
-        unsigned long delta = new_vsw - ps->voluntary_switches;
+    if (s->nvcsw > ps->voluntary_switches) {
+        unsigned long delta = s->nvcsw - ps->voluntary_switches;
         ps->context_switches += delta;
-        ps->voluntary_switches = new_vsw;
-        stats.total_context_switches += delta;
+        ps->voluntary_switches = s->nvcsw;
+        switches += delta;
     }
     
-    if (new_isw > ps->involuntary_switches) {
-        unsigned long delta = new_isw - ps->involuntary_switches;
+    if (s->nivcsw > ps->involuntary_switches) {
+        unsigned long delta = s->nivcsw - ps->involuntary_switches;
         ps->context_switches += delta;
-        ps->involuntary_switches = new_isw;
-        stats.total_context_switches += delta;
+        ps->involuntary_switches = s->nivcsw;
+        switches += delta;
+    }
+    stats.total_context_switches += switches;
+    topo_account_switches(s->cpu, switches);
+    
+    /* Track moves between cores, LLCs and nodes */
+    if (s->cpu != ps->last_cpu) {
+        topo_account_migration(ps->last_cpu, s->cpu);
+        ps->last_cpu = s->cpu;
     }
     
     /* Update runtime (approximate) - task is running if we see it */
-    ps->total_runtime_ns += (current_time - ps->last_seen_ns);
-    ps->last_seen_ns = current_time;
+    ps->total_runtime_ns += (now - ps->last_seen_ns);
+    ps->last_seen_ns = now;
     
     /* Update priority info */
-    ps->priority = task->prio;
-    ps->nice_value = task_nice(task);
+    ps->priority = s->prio;
+    ps->nice_value = s->nice;
+}
+
+/*
+ * Record one sample: find or create the entry and update it in a single
+ * critical section
+ */
+static void record_sample(const struct task_sample *s, u64 now)
+{
+    struct process_stats *ps;
+    unsigned long flags;
+    
+    spin_lock_irqsave(&stats_lock, flags);
+    
+    ps = process_stats_lookup(s->pid);
+    if (!ps)
+        ps = process_stats_insert(s, now);
+    if (ps)
+        process_stats_apply(ps, s, now);
+    
+    spin_unlock_irqrestore(&stats_lock, flags);
+}
+
+/*
+ * Update statistics for a process
+ */
+static void update_process_stats(struct task_struct *task)
+{
+    struct task_sample sample;
+    
+    if (!task)
+        return;
+    
+    sample.pid = task->pid;
+    sample.cpu = task_cpu(task);
+    sample.comm = task->comm;
+    sample.nvcsw = task->nvcsw;
+    sample.nivcsw = task->nivcsw;
+    sample.prio = task->prio;
+    sample.nice = task_nice(task);
+    
+    record_sample(&sample, ktime_get_ns());
+}
+
+/*
+ * Free all process statistics
+ */
+static void process_table_purge(void)
+{
+    struct process_stats *ps;
+    struct hlist_node *tmp;
+    int bkt;
+    unsigned long flags;
     
+    spin_lock_irqsave(&stats_lock, flags);
+    hash_for_each_safe(process_table, bkt, tmp, ps, hash_node) {
+        hash_del(&ps->hash_node);
+        kfree(ps);
+    }
     spin_unlock_irqrestore(&stats_lock, flags);
 }
 
@@ -164,17 +518,25 @@ static void update_process_stats(struct task_struct *task)
  */
 static void sampling_timer_callback(struct timer_list *timer)
 {
-    struct task_struct *task;
+    struct task_struct *p, *task;
     
     stats.sampling_count++;
     
-    /* Iterate through all processes and update stats */
+    /*
+     * Iterate through all threads: every one counts towards its CPU's
+     * runnable backlog, group leaders also update per-process stats
+     */
     rcu_read_lock();
-    for_each_process(task) {
-        update_process_stats(task);
+    for_each_process_thread(p, task) {
+        if (task_is_running(task))
+            cpu_runnable[task_cpu(task)]++;
+        if (task == p)
+            update_process_stats(task);
     }
     rcu_read_unlock();
     
+    topo_account_sample();
+    
     /* Re-arm timer */
     mod_timer(&sampling_timer, jiffies + msecs_to_jiffies(sampling_interval_ms));
 }
@@ -250,21 +612,458 @@ static const struct proc_ops sched_stats_ops = {
     .proc_release = single_release,
 };
 
+/*
+ * Topology proc show function - one row per core, LLC domain and node
+ */
+static int sched_topology_show(struct seq_file *m, void *v)
+{
+    unsigned long flags;
+    unsigned int i;
+    int level;
+    
+    seq_printf(m, "=== CPU Scheduler Topology Rollups ===\n\n");
+    seq_printf(m, "Sampling Interval: %u ms\n", sampling_interval_ms);
+    seq_printf(m, "Samples: %lu\n", topo_samples);
+    seq_printf(m, "Cores: %u  LLC Domains: %u  NUMA Nodes: %u\n\n",
+               topo[TOPO_CORE].nr_domains, topo[TOPO_LLC].nr_domains,
+               topo[TOPO_NODE].nr_domains);
+    
+    seq_printf(m, "%-6s %-6s %-9s %-6s %-14s %-14s %-9s %-12s %-12s %-12s\n",
+               "Level", "ID", "FirstCPU", "CPUs", "Switches", "Busy(ms)",
+               "Runnable", "AvgRunnable", "MigrIn", "MigrOut");
+    seq_printf(m, "%s\n", "------------------------------------------------------------"
+               "------------------------------------------------------");
+    
+    spin_lock_irqsave(&stats_lock, flags);
+    for (level = 0; level < TOPO_NR_LEVELS; level++) {
+        for (i = 0; i < topo[level].nr_domains; i++) {
+            struct topo_domain *d = &topo[level].domains[i];
+            unsigned long avg_x100 = topo_samples ?
+                d->runnable_sum * 100 / topo_samples : 0;
+            char avg[24];
+            
+            snprintf(avg, sizeof(avg), "%lu.%02lu", avg_x100 / 100, avg_x100 % 100);
+            seq_printf(m, "%-6s %-6u %-9u %-6u %-14lu %-14llu %-9lu %-12s %-12lu %-12lu\n",
+                       topo_level_names[level], i, d->first_cpu, d->nr_cpus,
+                       d->context_switches, div_u64(d->busy_ns, NSEC_PER_MSEC),
+                       d->runnable, avg, d->migrations_in, d->migrations_out);
+        }
+    }
+    spin_unlock_irqrestore(&stats_lock, flags);
+    
+    seq_printf(m, "\nNOTE: Switches and migrations are attributed to the CPU each process\n");
+    seq_printf(m, "  (thread group leader) was on at sampling time; Runnable counts all\n");
+    seq_printf(m, "  TASK_RUNNING threads per CPU at the last sample.\n");
+    
+    return 0;
+}
+
+static int sched_topology_open(struct inode *inode, struct file *file)
+{
+    return single_open(file, sched_topology_show, NULL);
+}
+
+static const struct proc_ops sched_topology_ops = {
+    .proc_open = sched_topology_open,
+    .proc_read = seq_read,
+    .proc_lseek = seq_lseek,
+    .proc_release = single_release,
+};
+
+#ifdef SCHED_MONITOR_KUNIT
+/*
+ * KUnit suite for the collection path (record_sample and the hash table),
+ * built with: make KUNIT=1. Suites in a module run once it is live, so the
+ * sampler is paused while they run and statistics start fresh afterwards.
+ */
+#define TEST_ROUNDS 10
+
+static const unsigned int test_sizes[] = { 1000, 10000, 100000 };
+
+static void test_size_desc(const unsigned int *size, char *desc)
+{
+    snprintf(desc, KUNIT_PARAM_DESC_SIZE, "%u tasks", *size);
+}
+
+KUNIT_ARRAY_PARAM(test_sizes, test_sizes, test_size_desc);
+
+/*
+ * Synthetic task state after seq updates: each update adds two voluntary
+ * and one involuntary switch, and alternates between the first and last
+ * online CPU
+ */
+static void test_sample(struct task_sample *s, pid_t pid, unsigned long seq)
+{
+    s->pid = pid;
+    s->cpu = (seq & 1) ? cpumask_last(cpu_online_mask) : cpumask_first(cpu_online_mask);
+    s->comm = "kunit";
+    s->nvcsw = 2 * seq;
+    s->nivcsw = seq;
+    s->nice = (int)(pid % 40) - 20;
+    s->prio = 120 + s->nice;
+}
+
+/* Number of table entries for a pid; more than one is a lost insert race */
+static unsigned int test_entries_for(pid_t pid)
+{
+    struct process_stats *ps;
+    unsigned int n = 0;
+    
+    hash_for_each_possible(process_table, ps, hash_node, pid) {
+        if (ps->pid == pid)
+            n++;
+    }
+    return n;
+}
+
+struct test_worker {
+    struct task_struct *thread;
+    unsigned int nr_entries;
+    atomic_t *updates;          /* Per-pid update sequence, shared by all workers */
+    struct completion started;  /* test_worker_fn is running */
+    struct completion done;
+    struct completion *go;
+};
+
+/*
+ * Every worker walks the same pids, so first-seen inserts and updates of
+ * one pid race across CPUs. With updates == NULL each pid is recorded at
+ * sequence 0 (insert only); otherwise each update takes the pid's next
+ * sequence number, which is what its counters are set to. Samples may
+ * reach the table out of order, but the final counters must still equal
+ * the number of updates.
+ */
+static int test_worker_fn(void *data)
+{
+    struct test_worker *w = data;
+    struct task_sample s;
+    unsigned int round, pid;
+    unsigned long ops = 0;
+    
+    complete(&w->started);
+    wait_for_completion(w->go);
+    for (round = 0; round < (w->updates ? TEST_ROUNDS : 1); round++) {
+        for (pid = 1; pid <= w->nr_entries; pid++) {
+            unsigned long seq = w->updates ? atomic_inc_return(&w->updates[pid - 1]) : 0;
+            
+            test_sample(&s, pid, seq);
+            record_sample(&s, 0);
+            if (!(++ops & 1023))
+                cond_resched();
+        }
+    }
+    complete(&w->done);
+    
+    /* Wait for kthread_stop() so we never return into a freed module */
+    set_current_state(TASK_INTERRUPTIBLE);
+    while (!kthread_should_stop()) {
+        schedule();
+        set_current_state(TASK_INTERRUPTIBLE);
+    }
+    __set_current_state(TASK_RUNNING);
+    return 0;
+}
+
+/*
+ * Run one pass of workers, one bound to each online CPU. Returns the
+ * elapsed time in ns and the number of workers through *nr_workers.
+ */
+static u64 test_run_workers(struct kunit *test, unsigned int nr_entries,
+                            atomic_t *updates, unsigned int *nr_workers)
+{
+    struct test_worker *workers;
+    DECLARE_COMPLETION_ONSTACK(go);
+    unsigned int i, n = 0;
+    u64 start, elapsed;
+    int cpu;
+    
+    workers = kunit_kcalloc(test, num_online_cpus(), sizeof(*workers), GFP_KERNEL);
+    KUNIT_ASSERT_NOT_NULL(test, workers);
+    
+    for_each_online_cpu(cpu) {
+        struct task_struct *thread;
+        
+        if (n == num_online_cpus())
+            break;
+        workers[n].nr_entries = nr_entries;
+        workers[n].updates = updates;
+        workers[n].go = &go;
+        init_completion(&workers[n].started);
+        init_completion(&workers[n].done);
+        thread = kthread_create(test_worker_fn, &workers[n], "sched_mon_kunit/%d", cpu);
+        if (IS_ERR(thread))
+            break;
+        kthread_bind(thread, cpu);
+        workers[n].thread = thread;
+        wake_up_process(thread);
+        n++;
+    }
+    
+    /*
+     * kthread_stop() on a thread that has not run yet makes it exit without
+     * calling test_worker_fn (one CPU, no preemption), so it is only used
+     * once every worker has signalled done
+     */
+    for (i = 0; i < n; i++)
+        wait_for_completion(&workers[i].started);
+    start = ktime_get_ns();
+    complete_all(&go);
+    for (i = 0; i < n; i++)
+        wait_for_completion(&workers[i].done);
+    elapsed = ktime_get_ns() - start;
+    for (i = 0; i < n; i++)
+        kthread_stop(workers[i].thread);
+    
+    *nr_workers = n;
+    KUNIT_ASSERT_EQ_MSG(test, n, num_online_cpus(), "cannot start worker threads");
+    return elapsed;
+}
+
+/*
+ * Single-threaded insert and lookup cost, including a miss
+ */
+static void sched_monitor_test_insert_lookup(struct kunit *test)
+{
+    const unsigned int nr_entries = *(const unsigned int *)test->param_value;
+    struct task_sample s;
+    unsigned int pid, found = 0;
+    u64 start, insert_ns, lookup_ns;
+    unsigned long flags;
+    bool miss;
+    
+    start = ktime_get_ns();
+    for (pid = 1; pid <= nr_entries; pid++) {
+        test_sample(&s, pid, 0);
+        record_sample(&s, 0);
+        if (!(pid & 1023))
+            cond_resched();
+    }
+    insert_ns = ktime_get_ns() - start;
+    KUNIT_ASSERT_EQ(test, stats.total_processes_tracked, (unsigned long)nr_entries);
+    
+    start = ktime_get_ns();
+    for (pid = 1; pid <= nr_entries; pid++) {
+        spin_lock_irqsave(&stats_lock, flags);
+        if (process_stats_lookup(pid))
+            found++;
+        spin_unlock_irqrestore(&stats_lock, flags);
+        if (!(pid & 1023))
+            cond_resched();
+    }
+    lookup_ns = ktime_get_ns() - start;
+    
+    spin_lock_irqsave(&stats_lock, flags);
+    miss = !process_stats_lookup(nr_entries + 1);
+    spin_unlock_irqrestore(&stats_lock, flags);
+    
+    KUNIT_EXPECT_EQ(test, found, nr_entries);
+    KUNIT_EXPECT_TRUE(test, miss);
+    kunit_info(test, "%u entries, %d buckets: insert %llu ns/op, lookup %llu ns/op\n",
+               nr_entries, PROCESS_HASH_SIZE, div_u64(insert_ns, nr_entries),
+               div_u64(lookup_ns, nr_entries));
+}
+
+/*
+ * All CPUs insert and then update the same pids concurrently: no pid may
+ * end up with two entries, and every pid's switch counts, the global total
+ * and the topology rollups must add up to the updates actually made
+ */
+static void sched_monitor_test_concurrent(struct kunit *test)
+{
+    const unsigned int nr_entries = *(const unsigned int *)test->param_value;
+    struct process_stats *ps;
+    atomic_t *updates;
+    unsigned long sum_cs = 0, seen = 0, bad = 0, flags;
+    unsigned int nr_workers, pid, dups = 0, missing = 0;
+    u64 update_ns;
+    int bkt, level;
+    
+    updates = kunit_kcalloc(test, nr_entries, sizeof(*updates), GFP_KERNEL);
+    KUNIT_ASSERT_NOT_NULL(test, updates);
+    
+    /* Racing first-seen inserts */
+    test_run_workers(test, nr_entries, NULL, &nr_workers);
+    
+    spin_lock_irqsave(&stats_lock, flags);
+    for (pid = 1; pid <= nr_entries; pid++) {
+        unsigned int n = test_entries_for(pid);
+        
+        dups += n > 1;
+        missing += n == 0;
+    }
+    spin_unlock_irqrestore(&stats_lock, flags);
+    KUNIT_EXPECT_EQ(test, dups, 0U);
+    KUNIT_EXPECT_EQ(test, missing, 0U);
+    KUNIT_ASSERT_EQ(test, stats.total_processes_tracked, (unsigned long)nr_entries);
+    
+    /* Racing updates of the same pids */
+    update_ns = test_run_workers(test, nr_entries, updates, &nr_workers);
+    
+    spin_lock_irqsave(&stats_lock, flags);
+    hash_for_each(process_table, bkt, ps, hash_node) {
+        unsigned long total = atomic_read(&updates[ps->pid - 1]);
+        
+        seen++;
+        sum_cs += ps->context_switches;
+        if (ps->context_switches != 3 * total ||
+            ps->voluntary_switches != 2 * total ||
+            ps->involuntary_switches != total)
+            bad++;
+    }
+    spin_unlock_irqrestore(&stats_lock, flags);
+    
+    KUNIT_EXPECT_EQ(test, seen, (unsigned long)nr_entries);
+    KUNIT_EXPECT_EQ_MSG(test, bad, 0UL, "pids whose counts differ from their updates");
+    KUNIT_EXPECT_EQ(test, sum_cs, 3UL * TEST_ROUNDS * nr_workers * nr_entries);
+    KUNIT_EXPECT_EQ(test, stats.total_context_switches, sum_cs);
+    
+    /* Rollups add up to the total; every migration leaves one domain for another */
+    for (level = 0; level < TOPO_NR_LEVELS; level++) {
+        struct topo_map *map = &topo[level];
+        unsigned long cs = 0, in = 0, out = 0;
+        unsigned int i;
+        
+        for (i = 0; i < map->nr_domains; i++) {
+            cs += map->domains[i].context_switches;
+            in += map->domains[i].migrations_in;
+            out += map->domains[i].migrations_out;
+        }
+        KUNIT_EXPECT_EQ_MSG(test, cs, sum_cs, "%s rollup", topo_level_names[level]);
+        KUNIT_EXPECT_EQ_MSG(test, in, out, "%s rollup", topo_level_names[level]);
+    }
+    
+    kunit_info(test, "%u entries, %u CPUs: update %llu ns/op\n", nr_entries, nr_workers,
+               div64_u64(update_ns, (u64)nr_entries * nr_workers * TEST_ROUNDS));
+}
+
+/*
+ * One task sampled in order: counters, runtime and migrations are exact,
+ * and a stale sample never moves a counter backwards
+ */
+static void sched_monitor_test_sequential(struct kunit *test)
+{
+    struct process_stats *ps, copy = {};
+    struct task_sample s;
+    unsigned long flags;
+    unsigned int seq;
+    bool found;
+    int level;
+    
+    for (seq = 0; seq <= TEST_ROUNDS; seq++) {
+        test_sample(&s, 1, seq);
+        record_sample(&s, (u64)seq * NSEC_PER_MSEC);
+    }
+    test_sample(&s, 1, 0);
+    record_sample(&s, (u64)(TEST_ROUNDS + 1) * NSEC_PER_MSEC);
+    
+    /* Copy the entry out: a failed assertion must not leave stats_lock held */
+    spin_lock_irqsave(&stats_lock, flags);
+    ps = process_stats_lookup(1);
+    found = ps != NULL;
+    if (found)
+        copy = *ps;
+    spin_unlock_irqrestore(&stats_lock, flags);
+    
+    KUNIT_ASSERT_TRUE(test, found);
+    KUNIT_EXPECT_EQ(test, copy.voluntary_switches, 2UL * TEST_ROUNDS);
+    KUNIT_EXPECT_EQ(test, copy.involuntary_switches, (unsigned long)TEST_ROUNDS);
+    KUNIT_EXPECT_EQ(test, copy.total_runtime_ns, (u64)(TEST_ROUNDS + 1) * NSEC_PER_MSEC);
+    KUNIT_EXPECT_EQ(test, copy.priority, s.prio);
+    KUNIT_EXPECT_EQ(test, copy.nice_value, s.nice);
+    KUNIT_EXPECT_STREQ(test, copy.comm, "kunit");
+    KUNIT_EXPECT_EQ(test, copy.context_switches, 3UL * TEST_ROUNDS);
+    KUNIT_EXPECT_EQ(test, stats.total_context_switches, copy.context_switches);
+    
+    /* Every in-order update after the first switches CPUs; the stale one does not */
+    for (level = 0; level < TOPO_NR_LEVELS; level++) {
+        struct topo_map *map = &topo[level];
+        unsigned long in = 0, moves = 0;
+        unsigned int i;
+        
+        if (map->cpu_domain[cpumask_first(cpu_online_mask)] !=
+            map->cpu_domain[cpumask_last(cpu_online_mask)])
+            moves = TEST_ROUNDS;
+        for (i = 0; i < map->nr_domains; i++)
+            in += map->domains[i].migrations_in;
+        KUNIT_EXPECT_EQ_MSG(test, in, moves, "%s rollup", topo_level_names[level]);
+    }
+}
+
+/* Each case starts from an empty table */
+static int sched_monitor_test_init(struct kunit *test)
+{
+    process_table_purge();
+    memset(&stats, 0, sizeof(stats));
+    topo_reset();
+    return 0;
+}
+
+static int sched_monitor_suite_init(struct kunit_suite *suite)
+{
+    del_timer_sync(&sampling_timer);
+    return 0;
+}
+
+static void sched_monitor_suite_exit(struct kunit_suite *suite)
+{
+    process_table_purge();
+    memset(&stats, 0, sizeof(stats));
+    stats.monitoring_start_time = ktime_get_ns();
+    topo_reset();
+    mod_timer(&sampling_timer, jiffies + msecs_to_jiffies(sampling_interval_ms));
+}
+
+static struct kunit_case sched_monitor_test_cases[] = {
+    KUNIT_CASE_PARAM(sched_monitor_test_insert_lookup, test_sizes_gen_params),
+    KUNIT_CASE_PARAM(sched_monitor_test_concurrent, test_sizes_gen_params),
+    KUNIT_CASE(sched_monitor_test_sequential),
+    {}
+};
+
+static struct kunit_suite sched_monitor_test_suite = {
+    .name = "sched_monitor",
+    .init = sched_monitor_test_init,
+    .suite_init = sched_monitor_suite_init,
+    .suite_exit = sched_monitor_suite_exit,
+    .test_cases = sched_monitor_test_cases,
+};
+
+kunit_test_suite(sched_monitor_test_suite);
+#endif /* SCHED_MONITOR_KUNIT */
+
 /*
  * Module initialization
  */
 static int __init sched_monitor_init(void)
 {
+    int ret;
+    
     pr_info("%s: Initializing CPU Scheduler Monitor\n", MODULE_NAME);
     
+    /* Build topology maps */
+    ret = topo_init();
+    if (ret) {
+        pr_err("%s: Failed to build CPU topology maps\n", MODULE_NAME);
+        return ret;
+    }
+    
     /* Initialize global statistics */
     memset(&stats, 0, sizeof(stats));
     stats.monitoring_start_time = ktime_get_ns();
     
-    /* Create proc entry */
+    /* Create proc entries */
     proc_entry = proc_create(PROC_NAME, 0444, NULL, &sched_stats_ops);
     if (!proc_entry) {
         pr_err("%s: Failed to create /proc/%s\n", MODULE_NAME, PROC_NAME);
+        topo_free();
+        return -ENOMEM;
+    }
+    
+    topo_proc_entry = proc_create(TOPO_PROC_NAME, 0444, NULL, &sched_topology_ops);
+    if (!topo_proc_entry) {
+        pr_err("%s: Failed to create /proc/%s\n", MODULE_NAME, TOPO_PROC_NAME);
+        proc_remove(proc_entry);
+        topo_free();
         return -ENOMEM;
     }
     
@@ -275,6 +1074,10 @@ static int __init sched_monitor_init(void)
     pr_info("%s: Module loaded successfully\n", MODULE_NAME);
     pr_info("%s: Statistics available at /proc/%s\n", MODULE_NAME, PROC_NAME);
     pr_info("%s: Sampling interval: %u ms\n", MODULE_NAME, sampling_interval_ms);
+    pr_info("%s: Hash table: %d buckets\n", MODULE_NAME, PROCESS_HASH_SIZE);
+    pr_info("%s: Topology: %u cores, %u LLC domains, %u NUMA nodes at /proc/%s\n",
+            MODULE_NAME, topo[TOPO_CORE].nr_domains, topo[TOPO_LLC].nr_domains,
+            topo[TOPO_NODE].nr_domains, TOPO_PROC_NAME);
     
     return 0;
 }
@@ -284,28 +1087,22 @@ static int __init sched_monitor_init(void)
  */
 static void __exit sched_monitor_exit(void)
 {
-    struct process_stats *ps;
-    struct hlist_node *tmp;
-    int bkt;
-    unsigned long flags;
-    
     pr_info("%s: Cleaning up CPU Scheduler Monitor\n", MODULE_NAME);
     
     /* Stop timer */
     del_timer_sync(&sampling_timer);
     
-    /* Remove proc entry */
+    /* Remove proc entries */
     if (proc_entry) {
         proc_remove(proc_entry);
     }
+    if (topo_proc_entry) {
+        proc_remove(topo_proc_entry);
+    }
     
     /* Free all process statistics */
-    spin_lock_irqsave(&stats_lock, flags);
-    hash_for_each_safe(process_table, bkt, tmp, ps, hash_node) {
-        hash_del(&ps->hash_node);
-        kfree(ps);
-    }
-    spin_unlock_irqrestore(&stats_lock, flags);
+    process_table_purge();
+    topo_free();
     
     pr_info("%s: Module unloaded successfully\n", MODULE_NAME);
 }
@@ -0,0 +1,777 @@
+/*
+ * sched_ts.c - Reader and writer for the .sts time-series format
+ *
+ * See sched_ts.h for the layout. All multi-byte fixed fields are
+ * little-endian; everything inside a block payload is a varint. Payloads
+ * are deflated with zlib when that makes them smaller.
+ *
+ * Block framing: u32 magic, u8 flags, u32 stored length, u32 raw length.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include "sched_ts.h"
+
+#define STS_MAGIC "SCHEDTS1"
+#define STS_VERSION 1
+#define STS_HEADER_SIZE 32
+#define STS_BLOCK_MAGIC 0x4B4C4253u     /* "SBLK" */
+#define STS_BLOCK_HEADER_SIZE 13
+#define STS_FLAG_KEYFRAME 0x01
+#define STS_FLAG_DEFLATE 0x02
+#define STS_MAX_BLOCK (64u << 20)
+
+/*
+ * Per-pid prediction state shared by writer and reader: the next value is
+ * expected to be value + delta. Both sides apply identical updates so the
+ * residuals in the file are all a reader needs.
+ */
+typedef struct {
+    int32_t pid;
+    char comm[STS_COMM_LEN];
+    int64_t value[STS_NUM_COUNTERS];
+    int64_t delta[STS_NUM_COUNTERS];
+} sts_state_t;
+
+typedef struct {
+    unsigned char *data;
+    size_t len;
+    size_t cap;
+} sts_buf_t;
+
+struct sts_writer {
+    FILE *data;
+    FILE *index;
+    unsigned keyframe_every;
+    uint64_t blocks;
+    uint64_t offset;
+    int64_t last_ts;
+    int64_t gvalue[STS_NUM_GLOBALS];
+    int64_t gdelta[STS_NUM_GLOBALS];
+    sts_state_t *state;
+    size_t nstate;
+    size_t state_cap;
+    sts_state_t *next_state;
+    size_t next_cap;
+    sts_buf_t buf;
+    unsigned char *zbuf;
+    size_t zbuf_cap;
+    /* Scratch columns for the rows that go into the current block */
+    int32_t *blk_pid;
+    int64_t *blk_resid[STS_NUM_COUNTERS];
+    size_t *name_row;
+    size_t blk_cap;
+    int32_t *removed;
+    size_t removed_cap;
+};
+
+struct sts_reader {
+    FILE *data;
+    unsigned interval_ms;
+    int64_t last_ts;
+    int need_keyframe;
+    int64_t gvalue[STS_NUM_GLOBALS];
+    int64_t gdelta[STS_NUM_GLOBALS];
+    sts_state_t *state;
+    size_t nstate;
+    sts_state_t *next_state;
+    size_t state_cap;
+    unsigned char *payload;
+    size_t payload_cap;
+    unsigned char *zbuf;
+    size_t zbuf_cap;
+    int64_t *index_ts;
+    uint64_t *index_off;
+    size_t nindex;
+    sts_snapshot_t snap;
+    size_t snap_cap;
+};
+
+/*
+ * Encoding helpers
+ */
+static int buf_reserve(sts_buf_t *b, size_t extra) {
+    if (b->len + extra <= b->cap)
+        return 0;
+    size_t cap = b->cap ? b->cap : 4096;
+    while (cap < b->len + extra)
+        cap *= 2;
+    unsigned char *data = realloc(b->data, cap);
+    if (!data)
+        return -1;
+    b->data = data;
+    b->cap = cap;
+    return 0;
+}
+
+static int put_uvarint(sts_buf_t *b, uint64_t v) {
+    if (buf_reserve(b, 10) < 0)
+        return -1;
+    while (v >= 0x80) {
+        b->data[b->len++] = (unsigned char)(v | 0x80);
+        v >>= 7;
+    }
+    b->data[b->len++] = (unsigned char)v;
+    return 0;
+}
+
+static int put_svarint(sts_buf_t *b, int64_t v) {
+    return put_uvarint(b, ((uint64_t)v << 1) ^ (uint64_t)(v >> 63));
+}
+
+static int put_bytes(sts_buf_t *b, const void *src, size_t len) {
+    if (buf_reserve(b, len) < 0)
+        return -1;
+    memcpy(b->data + b->len, src, len);
+    b->len += len;
+    return 0;
+}
+
+static int get_uvarint(const unsigned char **p, const unsigned char *end, uint64_t *out) {
+    uint64_t v = 0;
+    int shift = 0;
+
+    while (*p < end && shift < 64) {
+        unsigned char c = *(*p)++;
+        v |= (uint64_t)(c & 0x7f) << shift;
+        if (!(c & 0x80)) {
+            *out = v;
+            return 0;
+        }
+        shift += 7;
+    }
+    return -1;
+}
+
+static int get_svarint(const unsigned char **p, const unsigned char *end, int64_t *out) {
+    uint64_t u;
+
+    if (get_uvarint(p, end, &u) < 0)
+        return -1;
+    *out = (int64_t)(u >> 1) ^ -(int64_t)(u & 1);
+    return 0;
+}
+
+static void put_le(unsigned char *dst, uint64_t v, int bytes) {
+    for (int i = 0; i < bytes; i++)
+        dst[i] = (unsigned char)(v >> (8 * i));
+}
+
+static uint64_t get_le(const unsigned char *src, int bytes) {
+    uint64_t v = 0;
+    for (int i = 0; i < bytes; i++)
+        v |= (uint64_t)src[i] << (8 * i);
+    return v;
+}
+
+static int cmp_row_pid(const void *a, const void *b) {
+    const sts_row_t *x = a, *y = b;
+    return (x->pid > y->pid) - (x->pid < y->pid);
+}
+
+void sts_sort_rows(sts_row_t *rows, size_t nrows) {
+    qsort(rows, nrows, sizeof(*rows), cmp_row_pid);
+}
+
+/*
+ * Writer
+ */
+sts_writer_t *sts_writer_open(const char *path, unsigned interval_ms, unsigned keyframe_every) {
+    unsigned char header[STS_HEADER_SIZE] = {0};
+    char index_path[4096];
+    struct timespec ts;
+    sts_writer_t *w;
+
+    w = calloc(1, sizeof(*w));
+    if (!w)
+        return NULL;
+    w->keyframe_every = keyframe_every ? keyframe_every : 1;
+
+    snprintf(index_path, sizeof(index_path), "%s.idx", path);
+    w->data = fopen(path, "wb");
+    w->index = fopen(index_path, "wb");
+    if (!w->data || !w->index)
+        goto fail;
+    // Unbuffered so a failed block never lingers in stdio to be flushed later
+    setvbuf(w->data, NULL, _IONBF, 0);
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    memcpy(header, STS_MAGIC, 8);
+    put_le(header + 8, STS_VERSION, 4);
+    put_le(header + 12, interval_ms, 4);
+    put_le(header + 16, w->keyframe_every, 4);
+    put_le(header + 24, (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec, 8);
+    if (fwrite(header, 1, sizeof(header), w->data) != sizeof(header))
+        goto fail;
+    fflush(w->data);
+    w->offset = sizeof(header);
+    return w;
+
+fail:
+    sts_writer_close(w);
+    return NULL;
+}
+
+static int writer_grow(sts_writer_t *w, size_t nrows) {
+    if (nrows > w->next_cap) {
+        sts_state_t *s = realloc(w->next_state, nrows * sizeof(*s));
+        if (!s)
+            return -1;
+        w->next_state = s;
+        w->next_cap = nrows;
+    }
+    if (nrows > w->blk_cap) {
+        int32_t *pid = realloc(w->blk_pid, nrows * sizeof(*pid));
+        size_t *name_row = realloc(w->name_row, nrows * sizeof(*name_row));
+        if (pid)
+            w->blk_pid = pid;
+        if (name_row)
+            w->name_row = name_row;
+        if (!pid || !name_row)
+            return -1;
+        for (int c = 0; c < STS_NUM_COUNTERS; c++) {
+            int64_t *col = realloc(w->blk_resid[c], nrows * sizeof(*col));
+            if (!col)
+                return -1;
+            w->blk_resid[c] = col;
+        }
+        w->blk_cap = nrows;
+    }
+    if (w->nstate > w->removed_cap) {
+        int32_t *removed = realloc(w->removed, w->nstate * sizeof(*removed));
+        if (!removed)
+            return -1;
+        w->removed = removed;
+        w->removed_cap = w->nstate;
+    }
+    return 0;
+}
+
+int sts_writer_append(sts_writer_t *w, const sts_snapshot_t *snap) {
+    int keyframe = (w->blocks % w->keyframe_every) == 0;
+    unsigned char block_header[STS_BLOCK_HEADER_SIZE];
+    size_t nblk = 0, nnames = 0, nremoved = 0;
+    size_t i = 0, j = 0;
+    int32_t prev_pid = 0;
+    sts_buf_t *b = &w->buf;
+    const unsigned char *stored;
+    size_t stored_len;
+    uLongf zlen, bound;
+    unsigned char flags;
+    sts_state_t *swap;
+    /* Predictor state for this block; committed only once the block is written */
+    size_t nold = keyframe ? 0 : w->nstate;
+    uint64_t block_offset;
+    int64_t gvalue[STS_NUM_GLOBALS], gdelta[STS_NUM_GLOBALS];
+
+    if (writer_grow(w, snap->nrows) < 0)
+        return -1;
+
+    b->len = 0;
+    put_svarint(b, keyframe ? snap->timestamp_ns : snap->timestamp_ns - w->last_ts);
+
+    for (int g = 0; g < STS_NUM_GLOBALS; g++) {
+        int64_t v = snap->globals[g];
+        int64_t pv = keyframe ? 0 : w->gvalue[g], pd = keyframe ? 0 : w->gdelta[g];
+        put_svarint(b, v - (pv + pd));
+        gdelta[g] = keyframe ? 0 : v - pv;
+        gvalue[g] = v;
+    }
+
+    /* Merge the sorted snapshot with the sorted state */
+    while (i < snap->nrows || j < nold) {
+        const sts_row_t *row = i < snap->nrows ? &snap->rows[i] : NULL;
+        const sts_state_t *old = j < nold ? &w->state[j] : NULL;
+
+        if (old && (!row || old->pid < row->pid)) {
+            /* Gone from the module */
+            w->removed[nremoved++] = old->pid;
+            j++;
+            continue;
+        }
+
+        sts_state_t *next = &w->next_state[i];
+        int changed = 0;
+
+        next->pid = row->pid;
+        memcpy(next->comm, row->comm, STS_COMM_LEN);
+
+        if (old && old->pid == row->pid) {
+            for (int c = 0; c < STS_NUM_COUNTERS; c++) {
+                int64_t resid = row->counters[c] - (old->value[c] + old->delta[c]);
+                w->blk_resid[c][nblk] = resid;
+                changed |= resid != 0;
+                next->delta[c] = row->counters[c] - old->value[c];
+                next->value[c] = row->counters[c];
+            }
+            if (strncmp(old->comm, row->comm, STS_COMM_LEN) != 0) {
+                w->name_row[nnames++] = nblk;
+                changed = 1;
+            }
+            j++;
+        } else {
+            for (int c = 0; c < STS_NUM_COUNTERS; c++) {
+                w->blk_resid[c][nblk] = row->counters[c];
+                next->delta[c] = 0;
+                next->value[c] = row->counters[c];
+            }
+            w->name_row[nnames++] = nblk;
+            changed = 1;
+        }
+
+        if (changed)
+            w->blk_pid[nblk++] = row->pid;
+        i++;
+    }
+
+    /* Removed pids */
+    put_uvarint(b, nremoved);
+    prev_pid = 0;
+    for (size_t r = 0; r < nremoved; r++) {
+        put_uvarint(b, (uint64_t)(w->removed[r] - prev_pid));
+        prev_pid = w->removed[r];
+    }
+
+    /* Columns */
+    put_uvarint(b, nblk);
+    prev_pid = 0;
+    for (size_t r = 0; r < nblk; r++) {
+        put_uvarint(b, (uint64_t)(w->blk_pid[r] - prev_pid));
+        prev_pid = w->blk_pid[r];
+    }
+    for (int c = 0; c < STS_NUM_COUNTERS; c++) {
+        for (size_t r = 0; r < nblk; r++)
+            put_svarint(b, w->blk_resid[c][r]);
+    }
+
+    /* Names for new or renamed pids, by block row */
+    put_uvarint(b, nnames);
+    for (size_t n = 0; n < nnames; n++) {
+        size_t r = w->name_row[n];
+        const sts_row_t *row = bsearch(&(sts_row_t){ .pid = w->blk_pid[r] }, snap->rows,
+                                       snap->nrows, sizeof(sts_row_t), cmp_row_pid);
+        size_t len = strnlen(row->comm, STS_COMM_LEN);
+        put_uvarint(b, r);
+        put_uvarint(b, len);
+        put_bytes(b, row->comm, len);
+    }
+
+    if (b->len > STS_MAX_BLOCK) {
+        errno = EFBIG;
+        return -1;
+    }
+
+    /* Deflate the columns; residuals are mostly small and repetitive */
+    flags = keyframe ? STS_FLAG_KEYFRAME : 0;
+    stored = b->data;
+    stored_len = b->len;
+    bound = compressBound(b->len);
+    if (bound > w->zbuf_cap) {
+        unsigned char *zbuf = realloc(w->zbuf, bound);
+        if (!zbuf)
+            return -1;
+        w->zbuf = zbuf;
+        w->zbuf_cap = bound;
+    }
+    zlen = w->zbuf_cap;
+    if (compress2(w->zbuf, &zlen, b->data, b->len, Z_DEFAULT_COMPRESSION) == Z_OK &&
+        zlen < b->len) {
+        flags |= STS_FLAG_DEFLATE;
+        stored = w->zbuf;
+        stored_len = zlen;
+    }
+
+    /* Frame and write */
+    put_le(block_header, STS_BLOCK_MAGIC, 4);
+    block_header[4] = flags;
+    put_le(block_header + 5, stored_len, 4);
+    put_le(block_header + 9, b->len, 4);
+    if (fwrite(block_header, 1, sizeof(block_header), w->data) != sizeof(block_header) ||
+        fwrite(stored, 1, stored_len, w->data) != stored_len) {
+        /* Cut off whatever part of the block made it out */
+        int saved = errno;
+        clearerr(w->data);
+        if (ftruncate(fileno(w->data), w->offset) == 0)
+            fseeko(w->data, w->offset, SEEK_SET);
+        errno = saved;
+        return -1;
+    }
+
+    /* The block is in the file: later deltas may now be encoded against it */
+    block_offset = w->offset;
+    w->offset += sizeof(block_header) + stored_len;
+    w->blocks++;
+    w->last_ts = snap->timestamp_ns;
+    memcpy(w->gvalue, gvalue, sizeof(gvalue));
+    memcpy(w->gdelta, gdelta, sizeof(gdelta));
+    swap = w->state;
+    w->state = w->next_state;
+    w->nstate = snap->nrows;
+    w->next_state = swap;
+    {
+        size_t cap = w->state_cap;
+        w->state_cap = w->next_cap;
+        w->next_cap = cap;
+    }
+
+    if (keyframe) {
+        unsigned char entry[16];
+        put_le(entry, (uint64_t)snap->timestamp_ns, 8);
+        put_le(entry + 8, block_offset, 8);
+        if (fwrite(entry, 1, sizeof(entry), w->index) != sizeof(entry) ||
+            fflush(w->index) != 0)
+            return -1;
+    }
+    return 0;
+}
+
+uint64_t sts_writer_bytes(const sts_writer_t *w) {
+    return w->offset;
+}
+
+void sts_writer_close(sts_writer_t *w) {
+    if (!w)
+        return;
+    if (w->data)
+        fclose(w->data);
+    if (w->index)
+        fclose(w->index);
+    free(w->state);
+    free(w->next_state);
+    free(w->buf.data);
+    free(w->zbuf);
+    free(w->blk_pid);
+    free(w->name_row);
+    free(w->removed);
+    for (int c = 0; c < STS_NUM_COUNTERS; c++)
+        free(w->blk_resid[c]);
+    free(w);
+}
+
+/*
+ * Reader
+ */
+static void reader_load_index(sts_reader_t *r, const char *path) {
+    char index_path[4096];
+    unsigned char entry[16];
+    size_t cap = 0;
+    FILE *fp;
+
+    snprintf(index_path, sizeof(index_path), "%s.idx", path);
+    fp = fopen(index_path, "rb");
+    if (!fp)
+        return;
+
+    while (fread(entry, 1, sizeof(entry), fp) == sizeof(entry)) {
+        if (r->nindex == cap) {
+            size_t ncap = cap ? cap * 2 : 256;
+            int64_t *ts = realloc(r->index_ts, ncap * sizeof(*ts));
+            uint64_t *off = realloc(r->index_off, ncap * sizeof(*off));
+            if (ts)
+                r->index_ts = ts;
+            if (off)
+                r->index_off = off;
+            if (!ts || !off)
+                break;
+            cap = ncap;
+        }
+        r->index_ts[r->nindex] = (int64_t)get_le(entry, 8);
+        r->index_off[r->nindex] = get_le(entry + 8, 8);
+        r->nindex++;
+    }
+    fclose(fp);
+}
+
+sts_reader_t *sts_reader_open(const char *path) {
+    unsigned char header[STS_HEADER_SIZE];
+    sts_reader_t *r;
+
+    r = calloc(1, sizeof(*r));
+    if (!r)
+        return NULL;
+
+    r->data = fopen(path, "rb");
+    if (!r->data)
+        goto fail;
+    if (fread(header, 1, sizeof(header), r->data) != sizeof(header) ||
+        memcmp(header, STS_MAGIC, 8) != 0 || get_le(header + 8, 4) != STS_VERSION) {
+        errno = EINVAL;
+        goto fail;
+    }
+    r->interval_ms = get_le(header + 12, 4);
+    r->need_keyframe = 1;
+    reader_load_index(r, path);
+    return r;
+
+fail:
+    sts_reader_close(r);
+    return NULL;
+}
+
+unsigned sts_reader_interval_ms(const sts_reader_t *r) {
+    return r->interval_ms;
+}
+
+int sts_reader_seek(sts_reader_t *r, int64_t timestamp_ns) {
+    uint64_t offset = STS_HEADER_SIZE;
+    size_t lo = 0, hi = r->nindex;
+
+    /* Last keyframe with ts <= timestamp_ns */
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (r->index_ts[mid] <= timestamp_ns)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if (lo > 0)
+        offset = r->index_off[lo - 1];
+
+    r->nstate = 0;
+    r->need_keyframe = 1;
+    return fseeko(r->data, (off_t)offset, SEEK_SET);
+}
+
+static int reader_grow(sts_reader_t *r, size_t n) {
+    if (n <= r->state_cap)
+        return 0;
+    size_t cap = r->state_cap ? r->state_cap : 1024;
+    while (cap < n)
+        cap *= 2;
+    sts_state_t *a = realloc(r->state, cap * sizeof(*a));
+    if (!a)
+        return -1;
+    r->state = a;
+    sts_state_t *b = realloc(r->next_state, cap * sizeof(*b));
+    if (!b)
+        return -1;
+    r->next_state = b;
+    r->state_cap = cap;
+    return 0;
+}
+
+int sts_reader_next(sts_reader_t *r, const sts_snapshot_t **snap) {
+    unsigned char block_header[STS_BLOCK_HEADER_SIZE];
+    const unsigned char *p, *end;
+    uint64_t nremoved, nblk, nnames, u;
+    int64_t ts;
+    off_t start = ftello(r->data);
+    size_t len, raw_len, i = 0, k = 0, out = 0, rem = 0;
+    int keyframe, deflated;
+    int32_t *removed = NULL, *blk_pid = NULL;
+    int64_t *blk_resid = NULL;
+    char (*blk_name)[STS_COMM_LEN] = NULL;
+    unsigned char *blk_has_name = NULL;
+    int ret = -1;
+
+    len = fread(block_header, 1, sizeof(block_header), r->data);
+    if (len != sizeof(block_header)) {
+        /* Clean EOF or a block still being written: retry later */
+        fseeko(r->data, start, SEEK_SET);
+        return 0;
+    }
+    if (get_le(block_header, 4) != STS_BLOCK_MAGIC)
+        return -1;
+    keyframe = (block_header[4] & STS_FLAG_KEYFRAME) != 0;
+    deflated = (block_header[4] & STS_FLAG_DEFLATE) != 0;
+    len = get_le(block_header + 5, 4);
+    raw_len = get_le(block_header + 9, 4);
+    if (len > STS_MAX_BLOCK || raw_len > STS_MAX_BLOCK || (!deflated && len != raw_len))
+        return -1;
+    /* After a seek the first block must be a keyframe */
+    if (!keyframe && r->need_keyframe)
+        return -1;
+
+    if (raw_len > r->payload_cap) {
+        unsigned char *payload = realloc(r->payload, raw_len);
+        if (!payload)
+            return -1;
+        r->payload = payload;
+        r->payload_cap = raw_len;
+    }
+    if (deflated && len > r->zbuf_cap) {
+        unsigned char *zbuf = realloc(r->zbuf, len);
+        if (!zbuf)
+            return -1;
+        r->zbuf = zbuf;
+        r->zbuf_cap = len;
+    }
+    if (fread(deflated ? r->zbuf : r->payload, 1, len, r->data) != len) {
+        fseeko(r->data, start, SEEK_SET);
+        return 0;
+    }
+    if (deflated) {
+        uLongf out_len = raw_len;
+        if (uncompress(r->payload, &out_len, r->zbuf, len) != Z_OK || out_len != raw_len)
+            return -1;
+    }
+    r->need_keyframe = 0;
+    p = r->payload;
+    end = r->payload + raw_len;
+    len = raw_len;
+
+    if (keyframe) {
+        r->nstate = 0;
+        memset(r->gvalue, 0, sizeof(r->gvalue));
+        memset(r->gdelta, 0, sizeof(r->gdelta));
+    }
+
+    if (get_svarint(&p, end, &ts) < 0)
+        return -1;
+    r->last_ts = keyframe ? ts : r->last_ts + ts;
+    r->snap.timestamp_ns = r->last_ts;
+
+    for (int g = 0; g < STS_NUM_GLOBALS; g++) {
+        int64_t resid, v;
+        if (get_svarint(&p, end, &resid) < 0)
+            return -1;
+        v = r->gvalue[g] + r->gdelta[g] + resid;
+        r->gdelta[g] = keyframe ? 0 : v - r->gvalue[g];
+        r->gvalue[g] = v;
+        r->snap.globals[g] = v;
+    }
+
+    /* Removed pids */
+    if (get_uvarint(&p, end, &nremoved) < 0 || nremoved > len)
+        return -1;
+    removed = malloc((nremoved + 1) * sizeof(*removed));
+    if (!removed)
+        return -1;
+    for (uint64_t n = 0, prev = 0; n < nremoved; n++) {
+        if (get_uvarint(&p, end, &u) < 0)
+            goto out;
+        prev += u;
+        removed[n] = (int32_t)prev;
+    }
+
+    /* Columns */
+    if (get_uvarint(&p, end, &nblk) < 0 || nblk > len)
+        goto out;
+    blk_pid = malloc((nblk + 1) * sizeof(*blk_pid));
+    blk_resid = malloc((nblk + 1) * STS_NUM_COUNTERS * sizeof(*blk_resid));
+    blk_name = calloc(nblk + 1, sizeof(*blk_name));
+    blk_has_name = calloc(nblk + 1, 1);
+    if (!blk_pid || !blk_resid || !blk_name || !blk_has_name)
+        goto out;
+    for (uint64_t n = 0, prev = 0; n < nblk; n++) {
+        if (get_uvarint(&p, end, &u) < 0)
+            goto out;
+        prev += u;
+        blk_pid[n] = (int32_t)prev;
+    }
+    for (int c = 0; c < STS_NUM_COUNTERS; c++) {
+        for (uint64_t n = 0; n < nblk; n++) {
+            if (get_svarint(&p, end, &blk_resid[n * STS_NUM_COUNTERS + c]) < 0)
+                goto out;
+        }
+    }
+    if (get_uvarint(&p, end, &nnames) < 0)
+        goto out;
+    for (uint64_t n = 0; n < nnames; n++) {
+        uint64_t row, name_len;
+        if (get_uvarint(&p, end, &row) < 0 || row >= nblk ||
+            get_uvarint(&p, end, &name_len) < 0 || name_len >= STS_COMM_LEN ||
+            (size_t)(end - p) < name_len)
+            goto out;
+        memcpy(blk_name[row], p, name_len);
+        blk_name[row][name_len] = '\0';
+        blk_has_name[row] = 1;
+        p += name_len;
+    }
+
+    /* Apply: merge old state, removed list and block rows (all sorted by pid) */
+    if (reader_grow(r, r->nstate + nblk) < 0)
+        goto out;
+    while (i < r->nstate || k < nblk) {
+        sts_state_t *old = i < r->nstate ? &r->state[i] : NULL;
+        sts_state_t *next = &r->next_state[out];
+
+        if (old && (k >= nblk || old->pid < blk_pid[k])) {
+            while (rem < nremoved && removed[rem] < old->pid)
+                rem++;
+            i++;
+            if (rem < nremoved && removed[rem] == old->pid)
+                continue;
+            /* Unchanged: prediction was exact */
+            *next = *old;
+            for (int c = 0; c < STS_NUM_COUNTERS; c++)
+                next->value[c] = old->value[c] + old->delta[c];
+            out++;
+            continue;
+        }
+
+        next->pid = blk_pid[k];
+        if (old && old->pid == blk_pid[k]) {
+            memcpy(next->comm, blk_has_name[k] ? blk_name[k] : old->comm, STS_COMM_LEN);
+            for (int c = 0; c < STS_NUM_COUNTERS; c++) {
+                int64_t v = old->value[c] + old->delta[c] + blk_resid[k * STS_NUM_COUNTERS + c];
+                next->delta[c] = v - old->value[c];
+                next->value[c] = v;
+            }
+            i++;
+        } else {
+            if (!blk_has_name[k])
+                goto out;
+            memcpy(next->comm, blk_name[k], STS_COMM_LEN);
+            for (int c = 0; c < STS_NUM_COUNTERS; c++) {
+                next->value[c] = blk_resid[k * STS_NUM_COUNTERS + c];
+                next->delta[c] = 0;
+            }
+        }
+        k++;
+        out++;
+    }
+
+    {
+        sts_state_t *swap = r->state;
+        r->state = r->next_state;
+        r->next_state = swap;
+        r->nstate = out;
+    }
+
+    /* Materialize the snapshot */
+    if (r->nstate > r->snap_cap) {
+        sts_row_t *rows = realloc(r->snap.rows, r->nstate * sizeof(*rows));
+        if (!rows)
+            goto out;
+        r->snap.rows = rows;
+        r->snap_cap = r->nstate;
+    }
+    for (size_t n = 0; n < r->nstate; n++) {
+        r->snap.rows[n].pid = r->state[n].pid;
+        memcpy(r->snap.rows[n].comm, r->state[n].comm, STS_COMM_LEN);
+        memcpy(r->snap.rows[n].counters, r->state[n].value, sizeof(r->state[n].value));
+    }
+    r->snap.nrows = r->nstate;
+    *snap = &r->snap;
+    ret = 1;
+
+out:
+    free(removed);
+    free(blk_pid);
+    free(blk_resid);
+    free(blk_name);
+    free(blk_has_name);
+    return ret;
+}
+
+void sts_reader_close(sts_reader_t *r) {
+    if (!r)
+        return;
+    if (r->data)
+        fclose(r->data);
+    free(r->state);
+    free(r->next_state);
+    free(r->payload);
+    free(r->zbuf);
+    free(r->index_ts);
+    free(r->index_off);
+    free(r->snap.rows);
+    free(r);
+}
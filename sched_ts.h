@@ -0,0 +1,85 @@
+/*
+ * sched_ts.h - Compact time-series format for sched_monitor samples
+ *
+ * A .sts file is a header followed by one block per sample. Each block
+ * stores its rows column by column (pid, then each counter) as zigzag
+ * varints, deflated with zlib. Counters are coded against a per-pid
+ * prediction (last value plus last delta), so steadily growing or idle
+ * tasks cost nothing and are left out of the block entirely.
+ *
+ * Every keyframe_every blocks a keyframe restates all rows from scratch.
+ * Each keyframe's (timestamp, offset) is appended to a sidecar <file>.idx,
+ * so a reader can seek to any time by decoding from the nearest keyframe.
+ *
+ * sched_collector writes these files; sched_ts_dump and any other program
+ * linked with sched_ts.c can read them.
+ */
+
+#ifndef SCHED_TS_H
+#define SCHED_TS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define STS_COMM_LEN 32
+
+/* Per-process counters, in /proc/sched_stats column order */
+enum sts_counter {
+    STS_TOTAL_CS,
+    STS_VOLUNTARY_CS,
+    STS_INVOLUNTARY_CS,
+    STS_RUNTIME_MS,
+    STS_PRIORITY,
+    STS_NICE,
+    STS_NUM_COUNTERS
+};
+
+/* Module-wide counters from the /proc/sched_stats header */
+enum sts_global {
+    STS_SAMPLES_TAKEN,
+    STS_PROCESSES_TRACKED,
+    STS_GLOBAL_CS,
+    STS_NUM_GLOBALS
+};
+
+typedef struct {
+    int32_t pid;
+    char comm[STS_COMM_LEN];
+    int64_t counters[STS_NUM_COUNTERS];
+} sts_row_t;
+
+typedef struct {
+    int64_t timestamp_ns;               /* CLOCK_REALTIME */
+    int64_t globals[STS_NUM_GLOBALS];
+    size_t nrows;
+    sts_row_t *rows;                    /* Sorted by pid */
+} sts_snapshot_t;
+
+typedef struct sts_writer sts_writer_t;
+typedef struct sts_reader sts_reader_t;
+
+/* Writer: returns NULL on error (errno set) */
+sts_writer_t *sts_writer_open(const char *path, unsigned interval_ms, unsigned keyframe_every);
+/* Append one snapshot; rows must be sorted by pid. Returns 0 or -1. */
+int sts_writer_append(sts_writer_t *w, const sts_snapshot_t *snap);
+/* Bytes written to the data file so far */
+uint64_t sts_writer_bytes(const sts_writer_t *w);
+void sts_writer_close(sts_writer_t *w);
+
+/* Reader: returns NULL on error (errno set) */
+sts_reader_t *sts_reader_open(const char *path);
+unsigned sts_reader_interval_ms(const sts_reader_t *r);
+/* Position before the last keyframe at or before timestamp_ns. Returns 0 or -1. */
+int sts_reader_seek(sts_reader_t *r, int64_t timestamp_ns);
+/*
+ * Decode the next snapshot. The snapshot is owned by the reader and stays
+ * valid until the next call. Returns 1 on success, 0 at end of file, -1 on
+ * a corrupt or truncated block.
+ */
+int sts_reader_next(sts_reader_t *r, const sts_snapshot_t **snap);
+void sts_reader_close(sts_reader_t *r);
+
+/* Sort helper for building snapshots */
+void sts_sort_rows(sts_row_t *rows, size_t nrows);
+
+#endif /* SCHED_TS_H */
@@ -8,10 +8,14 @@ showing the timeline of test processes (CPU-bound, I/O-bound, Mixed workloads).
 Usage:
     python3 visualize_results.py [results_directory]
     python3 visualize_results.py --latest
+    python3 visualize_results.py --capture results/sched_20250101_120000.sts --save
 
 Options:
     results_directory: Path to results directory (default: ./results)
     --latest: Automatically use the most recent results
+    --capture: Chart a continuous capture on its real timeline instead of the
+               phase snapshots: a sched_collector .sts file (decoded with
+               sched_ts_dump) or the CSV sched_ts_dump prints
     --save: Save the charts as PNG files instead of displaying
     --format: Output format (png, pdf, svg) default: png
 """
@@ -19,10 +23,12 @@ Options:
 import os
 import sys
 import re
+import shutil
 import argparse
+import subprocess
 from datetime import datetime
 from pathlib import Path
-from typing import Dict, List, Tuple, Optional
+from typing import Dict, Iterator, List, Tuple, Optional
 import matplotlib.pyplot as plt
 import matplotlib.patches as mpatches
 from matplotlib.patches import Rectangle
@@ -43,6 +49,405 @@ class ProcessData:
         self.nice = nice
 
 
+# ---------------------------------------------------------------------------
+# Columnar loader
+#
+# Continuous captures come from sched_collector, which stamps every sample
+# with a nanosecond timestamp:
+#   ./sched_collector -i 100 -o results/capture.sts
+# They are decoded by sched_ts_dump and its CSV is streamed in fixed-size
+# chunks straight into numpy columns, so memory stays bounded by the chunk
+# size and the number of distinct processes, not the capture size. The
+# phase snapshot files (plain /proc/sched_stats dumps) go through the same
+# columns; their only clock is the module's whole-second uptime.
+# ---------------------------------------------------------------------------
+
+STATS_HEADER = b'=== CPU Scheduler Monitoring Statistics ==='
+DURATION_RE = re.compile(rb'^Monitoring Duration: (\d+)', re.M)
+ROW_RE = re.compile(rb'^ *(\d+) +(\S.*?) +(-?\d+) +(-?\d+) +(-?\d+) +(-?\d+) +(-?\d+) +(-?\d+) *$', re.M)
+CHUNK_BYTES = 16 << 20
+NSEC_PER_SEC = 1_000_000_000
+STS_CSV_HEADER = b'timestamp_ns,pid,comm,'
+
+# Numeric columns in /proc/sched_stats order (after PID and Command)
+COUNTER_COLUMNS = ('total_cs', 'voluntary_cs', 'involuntary_cs', 'runtime_ms', 'priority', 'nice')
+# Cumulative counters that get per-interval deltas and rates
+RATE_COLUMNS = ('total_cs', 'voluntary_cs', 'involuntary_cs', 'runtime_ms')
+
+# Row layout written by sched_stats_show(): "%-8d %-20s %-12lu %-12lu %-12lu %-12llu %-8d %-8d\n"
+ROW_FIELDS = (('pid', 8), ('comm', 20), ('total_cs', 12), ('voluntary_cs', 12),
+              ('involuntary_cs', 12), ('runtime_ms', 12), ('priority', 8), ('nice', 8))
+ROW_WIDTH = sum(width + 1 for _, width in ROW_FIELDS)
+ROW_OFFSETS = np.cumsum([0] + [width + 1 for _, width in ROW_FIELDS])
+ROW_GAPS = ROW_OFFSETS[1:] - 1
+ROW_SEPARATORS = np.array([ord(' ')] * (len(ROW_FIELDS) - 1) + [ord('\n')], dtype=np.uint8)
+
+
+class CommTable:
+    """Interns command names so rows can carry an integer code."""
+    def __init__(self):
+        self.names: List[str] = []
+        self.codes: Dict[bytes, int] = {}
+
+    def encode(self, raw: np.ndarray) -> np.ndarray:
+        # Group on a 64-bit hash of the name (sorting fixed-width strings is
+        # slow), falling back to exact grouping if two names collide
+        first = None
+        if raw.itemsize <= 24:
+            padded = np.zeros((len(raw), 24), dtype=np.uint8)
+            padded[:, :raw.itemsize] = raw.view(np.uint8).reshape(len(raw), raw.itemsize)
+            words = padded.view(np.uint64)
+            key = words[:, 0] * np.uint64(0x9E3779B97F4A7C15) ^ words[:, 1] * np.uint64(31) ^ words[:, 2]
+            _, first, inverse = np.unique(key, return_index=True, return_inverse=True)
+            inverse = inverse.reshape(-1)
+            if not (raw[first][inverse] == raw).all():
+                first = None
+        if first is None:
+            _, first, inverse = np.unique(raw, return_index=True, return_inverse=True)
+            inverse = inverse.reshape(-1)
+
+        lookup = np.empty(len(first), dtype=np.int32)
+        for i, name in enumerate(raw[first]):
+            name = name.rstrip()
+            code = self.codes.get(name)
+            if code is None:
+                code = self.codes[name] = len(self.names)
+                self.names.append(name.decode('utf-8', 'replace'))
+            lookup[i] = code
+        return lookup[inverse]
+
+
+def _empty_columns() -> Dict[str, np.ndarray]:
+    cols = {name: np.empty(0, dtype=np.int64)
+            for name in ('snapshot', 'time_ns', 'pid') + COUNTER_COLUMNS}
+    cols['comm'] = np.empty(0, dtype=np.int32)
+    return cols
+
+
+def parse_table(dump: bytes) -> Tuple[np.ndarray, np.ndarray]:
+    """
+    Decode the process table of one dump.
+
+    Returns (numbers, comms): an (n, 7) int64 array of pid plus counters and
+    the raw command names. Tables in the module's fixed-width layout are
+    decoded by blanking the Command column and handing the rest to numpy's
+    number parser in one call; anything else (hand-edited files, values
+    overflowing a column) goes through ROW_RE.
+    """
+    sep = dump.find(b'\n---')
+    if sep >= 0:
+        body_start = dump.find(b'\n', sep + 1) + 1
+        body_end = dump.find(b'\n\n', body_start) + 1 or len(dump)
+        if body_start > 0 and (body_end - body_start) % ROW_WIDTH == 0:
+            raw = np.frombuffer(dump, dtype=np.uint8, count=body_end - body_start,
+                                offset=body_start).reshape(-1, ROW_WIDTH)
+            if (raw[:, ROW_GAPS] == ROW_SEPARATORS).all():
+                comm_cols = slice(ROW_OFFSETS[1], ROW_GAPS[1])
+                comm = np.ascontiguousarray(raw[:, comm_cols]).view(f'S{ROW_FIELDS[1][1]}').reshape(-1)
+                text = raw.copy()
+                text[:, comm_cols] = ord(' ')
+                numbers = np.fromstring(text.tobytes(), dtype=np.int64, sep=' ')
+                if numbers.size == len(raw) * 7:
+                    return numbers.reshape(-1, 7), comm
+
+    matches = ROW_RE.findall(dump)
+    if not matches:
+        return np.empty((0, 7), dtype=np.int64), np.empty(0, dtype='S1')
+    fields = np.array(matches, dtype=bytes)
+    return fields[:, [0, 2, 3, 4, 5, 6, 7]].astype(np.int64), fields[:, 1]
+
+
+def iter_stats_chunks(filepath: Path, comms: CommTable,
+                      chunk_bytes: int = CHUNK_BYTES) -> Iterator[Dict[str, np.ndarray]]:
+    """
+    Stream a stats file as column chunks.
+
+    Each chunk is a dict of equal-length arrays: snapshot (index of the dump
+    in the file), time_ns (module uptime of that dump, whole seconds only),
+    pid, comm (code into comms.names) and the counter columns. Chunks hold
+    whole dumps.
+    """
+    snapshot = -1
+    carry = b''
+
+    with open(filepath, 'rb') as f:
+        while True:
+            block = f.read(chunk_bytes)
+            text = carry + block
+            if block:
+                # Keep the last (possibly partial) dump for the next round
+                cut = text.rfind(STATS_HEADER)
+                if cut <= 0:
+                    carry = text
+                    continue
+                text, carry = text[:cut], text[cut:]
+            if not text:
+                break
+
+            numbers, comm, snaps, times = [], [], [], []
+            for dump in text.split(STATS_HEADER):
+                if not dump or dump.isspace():
+                    continue
+                snapshot += 1
+                duration = DURATION_RE.search(dump)
+                rows, names = parse_table(dump)
+                if not len(rows):
+                    continue
+                numbers.append(rows)
+                comm.append(names)
+                snaps.append(np.full(len(rows), snapshot, dtype=np.int64))
+                times.append(np.full(len(rows), int(duration.group(1)) * NSEC_PER_SEC
+                                     if duration else 0, dtype=np.int64))
+
+            if numbers:
+                numbers = np.concatenate(numbers)
+                cols = {'snapshot': np.concatenate(snaps),
+                        'time_ns': np.concatenate(times),
+                        'pid': numbers[:, 0],
+                        'comm': comms.encode(np.concatenate(comm))}
+                for j, name in enumerate(COUNTER_COLUMNS):
+                    cols[name] = numbers[:, j + 1]
+                yield cols
+
+            if not block:
+                break
+
+
+def parse_sts_csv(text: bytes) -> Tuple[np.ndarray, np.ndarray]:
+    """
+    Decode whole lines of sched_ts_dump CSV.
+
+    Returns (numbers, comms): an (n, 8) int64 array of timestamp_ns, pid
+    and the counters, and the command names. comm is the only quoted field
+    and numbers never contain quotes, so a line's first and last quote
+    bound its name. The names are gathered into a fixed-width array, and
+    the numbers are parsed by numpy in one call once each '"comm",' is
+    blanked out.
+    """
+    raw = np.frombuffer(text, dtype=np.uint8)
+    ends = np.flatnonzero(raw == ord('\n'))
+    quotes = np.flatnonzero(raw == ord('"'))
+    per_line = np.bincount(np.searchsorted(ends, quotes), minlength=len(ends))[:len(ends)]
+    if (per_line < 2).any():
+        raise ValueError('malformed sched_ts_dump CSV')
+    last = np.cumsum(per_line) - 1
+    closing = quotes[last]
+    opening = quotes[last - per_line + 1]
+
+    # Blank '"comm",' on each line: opening quote through the comma after it
+    span = closing + 2 - opening
+    numbers = raw.copy()
+    numbers[np.arange(span.sum()) + np.repeat(opening - np.cumsum(span) + span, span)] = ord(' ')
+    numbers[ends] = ord(',')
+    values = np.fromstring(numbers.tobytes(), dtype=np.int64, sep=',')
+    if values.size != len(ends) * 8:
+        raise ValueError('malformed sched_ts_dump CSV')
+
+    length = closing - opening - 1
+    width = max(int(length.max()), 1)
+    offsets = np.arange(width)
+    names = raw[np.minimum(opening[:, None] + 1 + offsets, len(raw) - 1)]
+    names = np.where(offsets < length[:, None], names, 0).astype(np.uint8)
+    comm = np.ascontiguousarray(names).view(f'S{width}').reshape(-1)
+    for i in np.flatnonzero(per_line > 2):
+        comm[i] = comm[i].replace(b'""', b'"')
+    return values.reshape(-1, 8), comm
+
+
+def sts_dump_tool() -> Optional[str]:
+    """sched_ts_dump next to this script, else on PATH."""
+    local = Path(__file__).resolve().parent / 'sched_ts_dump'
+    if local.exists():
+        return str(local)
+    return shutil.which('sched_ts_dump')
+
+
+def iter_sts_chunks(filepath: Path, comms: CommTable,
+                    chunk_bytes: int = CHUNK_BYTES) -> Iterator[Dict[str, np.ndarray]]:
+    """
+    Stream a sched_collector capture as column chunks.
+
+    Accepts a .sts file, decoded through sched_ts_dump, or that tool's CSV
+    output. Columns match iter_stats_chunks(), with time_ns taken from the
+    sample timestamps; snapshot counts distinct timestamps.
+    """
+    proc = None
+    if filepath.suffix == '.sts':
+        tool = sts_dump_tool()
+        if not tool:
+            raise FileNotFoundError('sched_ts_dump not found (run: make collector)')
+        proc = subprocess.Popen([tool, str(filepath)], stdout=subprocess.PIPE)
+        stream = proc.stdout
+    else:
+        stream = open(filepath, 'rb')
+
+    snapshot, last_ts = -1, None
+    carry = b''
+    try:
+        header = stream.readline()
+        if not header.startswith(STS_CSV_HEADER):
+            raise ValueError(f'{filepath}: not a sched_ts_dump per-process CSV')
+        while True:
+            block = stream.read(chunk_bytes)
+            text = carry + block
+            if block:
+                # comm never holds a newline (rows come from single lines of
+                # /proc/sched_stats), so every newline ends a record
+                cut = text.rfind(b'\n') + 1
+                text, carry = text[:cut], text[cut:]
+            if text:
+                numbers, names = parse_sts_csv(text)
+                ts = numbers[:, 0]
+                starts = np.empty(len(ts), dtype=bool)
+                starts[0] = ts[0] != last_ts
+                starts[1:] = ts[1:] != ts[:-1]
+                snaps = snapshot + np.cumsum(starts)
+                snapshot, last_ts = int(snaps[-1]), ts[-1]
+
+                cols = {'snapshot': snaps,
+                        'time_ns': ts,
+                        'pid': numbers[:, 1],
+                        'comm': comms.encode(names)}
+                for j, name in enumerate(COUNTER_COLUMNS):
+                    cols[name] = numbers[:, j + 2]
+                yield cols
+            if not block:
+                break
+    finally:
+        stream.close()
+        if proc and proc.wait() != 0:
+            print(f"Warning: sched_ts_dump exited with status {proc.returncode}; "
+                  f"capture may be truncated")
+
+
+def load_stats_columns(filepath: Path, comms: CommTable) -> Dict[str, np.ndarray]:
+    """Load a whole stats file into columns (use for snapshots and small captures)."""
+    chunks = list(iter_stats_chunks(filepath, comms))
+    if not chunks:
+        return _empty_columns()
+    return {name: np.concatenate([c[name] for c in chunks]) for name in chunks[0]}
+
+
+def pid_order(cols: Dict[str, np.ndarray]) -> np.ndarray:
+    """Row order by (pid, snapshot), from a single sort on a combined key."""
+    snapshot = cols['snapshot'] - (cols['snapshot'].min() if len(cols['snapshot']) else 0)
+    return np.argsort((cols['pid'] << 32) | snapshot)
+
+
+def compute_deltas(cols: Dict[str, np.ndarray],
+                   order: Optional[np.ndarray] = None) -> Dict[str, np.ndarray]:
+    """
+    Per-process deltas between consecutive snapshots, as columns.
+
+    Rows are ordered by (pid, snapshot); each output row is one interval of
+    one process (dt_s from the nanosecond timestamps), with d_<counter> and
+    <counter>_per_s for the cumulative counters. A counter that goes backwards means the pid was reused, so
+    the new value is taken as the delta.
+    """
+    if order is None:
+        order = pid_order(cols)
+    pid = cols['pid'][order]
+    time_ns = cols['time_ns'][order]
+    same = pid[1:] == pid[:-1]
+
+    dt = (time_ns[1:] - time_ns[:-1])[same] / NSEC_PER_SEC
+    out = {'pid': pid[1:][same],
+           'snapshot': cols['snapshot'][order][1:][same],
+           'time_ns': time_ns[1:][same],
+           'dt_s': dt}
+    for name in RATE_COLUMNS:
+        value = cols[name][order]
+        cur = value[1:][same]
+        delta = cur - value[:-1][same]
+        delta = np.where(delta < 0, cur, delta)
+        out[f'd_{name}'] = delta
+        with np.errstate(divide='ignore', invalid='ignore'):
+            out[f'{name}_per_s'] = np.where(dt > 0, delta / dt, np.nan)
+    return out
+
+
+class CaptureSummary:
+    """
+    Per-process summary of a capture, built chunk by chunk.
+
+    Keeps one entry per pid: when it was first/last seen, its latest
+    counters, and its peak context switch rate. Rates that span a chunk
+    boundary are computed against the previous chunk's last row.
+    """
+    def __init__(self):
+        self.comms = CommTable()
+        self.pid = np.empty(0, dtype=np.int64)
+        self.first_ns = np.empty(0, dtype=np.int64)
+        self.last: Dict[str, np.ndarray] = _empty_columns()
+        self.peak_cs_per_s = np.empty(0, dtype=np.float64)
+        self.snapshots = 0
+        self.rows = 0
+
+    def add_chunk(self, cols: Dict[str, np.ndarray]):
+        # Prepend each known pid's previous last row so deltas cross chunks
+        known = np.isin(self.pid, cols['pid'])
+        merged = {name: np.concatenate([self.last[name][known], cols[name]])
+                  for name in cols}
+        order = pid_order(merged)
+        deltas = compute_deltas(merged, order)
+
+        pid = merged['pid'][order]
+        is_last = np.append(pid[1:] != pid[:-1], True)
+        is_first = np.insert(pid[1:] != pid[:-1], 0, True)
+        chunk_pid = pid[is_last]
+        chunk_last = {name: merged[name][order][is_last] for name in merged}
+        chunk_first_ns = merged['time_ns'][order][is_first]
+
+        chunk_peak = np.zeros(len(chunk_pid))
+        if len(deltas['pid']):
+            rate = np.nan_to_num(deltas['total_cs_per_s'])
+            idx = np.searchsorted(chunk_pid, deltas['pid'])
+            np.maximum.at(chunk_peak, idx, rate)
+
+        # Merge into the running table (both sides sorted by pid)
+        all_pid = np.union1d(self.pid, chunk_pid)
+        old = np.searchsorted(all_pid, self.pid)
+        new = np.searchsorted(all_pid, chunk_pid)
+
+        first_ns = np.zeros(len(all_pid), dtype=np.int64)
+        first_ns[new] = chunk_first_ns
+        first_ns[old] = self.first_ns
+        peak = np.zeros(len(all_pid))
+        peak[old] = self.peak_cs_per_s
+        peak[new] = np.maximum(peak[new], chunk_peak)
+        last = {}
+        for name in self.last:
+            column = np.zeros(len(all_pid), dtype=self.last[name].dtype)
+            column[old] = self.last[name]
+            column[new] = chunk_last[name]
+            last[name] = column
+
+        self.pid, self.first_ns, self.peak_cs_per_s, self.last = all_pid, first_ns, peak, last
+        self.snapshots = max(self.snapshots, int(cols['snapshot'].max()) + 1)
+        self.rows += len(cols['pid'])
+
+    def start_ns(self) -> int:
+        return int(self.first_ns.min()) if len(self.first_ns) else 0
+
+    def process(self, i: int) -> ProcessData:
+        last = self.last
+        return ProcessData(
+            int(self.pid[i]), self.comms.names[last['comm'][i]],
+            int(last['total_cs'][i]), int(last['voluntary_cs'][i]),
+            int(last['involuntary_cs'][i]), int(last['runtime_ms'][i]),
+            int(last['priority'][i]), int(last['nice'][i])
+        )
+
+
+def summarize_capture(filepath: Path, chunk_bytes: int = CHUNK_BYTES) -> CaptureSummary:
+    """Stream a capture (.sts, sched_ts_dump CSV or stats dumps) into a CaptureSummary."""
+    summary = CaptureSummary()
+    reader = iter_sts_chunks if filepath.suffix in ('.sts', '.csv') else iter_stats_chunks
+    for cols in reader(filepath, summary.comms, chunk_bytes):
+        summary.add_chunk(cols)
+    return summary
+
+
 class SchedulerResults:
     """Parser for scheduler monitoring results."""
     
@@ -65,48 +470,15 @@ class SchedulerResults:
         return None
     
     def parse_stats_file(self, filepath: Path) -> Dict[int, ProcessData]:
-        """Parse a single stats file and return process data."""
+        """Parse a single stats file and return process data (last snapshot wins)."""
         processes = {}
         if not filepath.exists():
             return processes
-            
-        with open(filepath, 'r') as f:
-            lines = f.readlines()
-            
-        # Find the data section (after header lines)
-        data_start = 0
-        for i, line in enumerate(lines):
-            if line.startswith('---'):
-                data_start = i + 1
-                break
-        
-        # Parse process data
-        for line in lines[data_start:]:
-            line = line.strip()
-            if not line or line.startswith('='):
-                continue
-                
-            parts = line.split()
-            if len(parts) < 8:
-                continue
-                
-            try:
-                pid = int(parts[0])
-                command = parts[1]
-                total_cs = int(parts[2])
-                vol_cs = int(parts[3])
-                invol_cs = int(parts[4])
-                runtime_ms = int(parts[5])
-                priority = int(parts[6])
-                nice = int(parts[7])
-                
-                processes[pid] = ProcessData(
-                    pid, command, total_cs, vol_cs, invol_cs, 
-                    runtime_ms, priority, nice
-                )
-            except (ValueError, IndexError):
-                continue
-                
+
+        summary = summarize_capture(filepath)
+        for i, pid in enumerate(summary.pid):
+            processes[int(pid)] = summary.process(i)
+
         return processes
     
     def load_all_results(self):
@@ -315,6 +687,125 @@ def create_gantt_chart(timeline: Dict[str, List[Tuple[str, ProcessData]]],
     plt.close()
 
 
+def create_capture_gantt_chart(summary: CaptureSummary,
+                               save_path: Optional[str] = None,
+                               format: str = 'png'):
+    """Create Gantt chart from a capture, using when each process was actually seen."""
+
+    colors = {
+        'test_cpu': '#FF6B6B',      # Red
+        'test_io': '#4ECDC4',       # Teal
+        'test_mixed': '#45B7D1',    # Blue
+    }
+    workload_types = [('CPU-Bound (test_cpu)', 'test_cpu'),
+                      ('I/O-Bound (test_io)', 'test_io'),
+                      ('Mixed (test_mixed)', 'test_mixed')]
+
+    origin = summary.start_ns()
+    first_s = (summary.first_ns - origin) / NSEC_PER_SEC
+    last_s = (summary.last['time_ns'] - origin) / NSEC_PER_SEC
+    end = max(float(last_s.max()), 1.0) if len(summary.pid) else 1.0
+    names = np.array(summary.comms.names, dtype=object)
+
+    fig = plt.figure(figsize=(16, 10))
+    gs = fig.add_gridspec(3, 1, hspace=0.4)
+    axes = [fig.add_subplot(gs[i]) for i in range(3)]
+
+    for (workload_name, cmd), ax in zip(workload_types, axes):
+        idx = np.nonzero(names[summary.last['comm']] == cmd)[0]
+        idx = idx[np.argsort(first_s[idx], kind='stable')]
+        ax.set_xlim(0, end)
+        ax.set_xlabel('Time (seconds)', fontsize=11)
+        ax.set_ylabel(workload_name, fontsize=11, fontweight='bold')
+        ax.grid(True, axis='x', alpha=0.3, linestyle='--')
+
+        if not len(idx):
+            ax.text(0.5, 0.5, f'No {workload_name} processes found',
+                   ha='center', va='center', transform=ax.transAxes)
+            ax.set_ylim(0, 1)
+            ax.set_yticks([])
+            continue
+
+        # One lane per process; a process seen in one snapshot still gets a sliver
+        for lane, i in enumerate(idx):
+            proc = summary.process(i)
+            start = first_s[i]
+            duration = max(last_s[i] - first_s[i], end * 0.005)
+            rect = Rectangle((start, lane + 0.1), duration, 0.8,
+                           linewidth=1, edgecolor='black', facecolor=colors[cmd], alpha=0.7)
+            ax.add_patch(rect)
+            if len(idx) <= 12:
+                label = (f"PID {proc.pid}  CS: {proc.total_cs}  Invol: {proc.involuntary_cs}  "
+                         f"Peak: {summary.peak_cs_per_s[i]:.0f} CS/s")
+                ax.text(start + duration / 2, lane + 0.5, label,
+                       ha='center', va='center', fontsize=8, fontweight='bold')
+
+        ax.set_ylim(0, len(idx))
+        ax.set_yticks([])
+
+    fig.suptitle(f'Kernel Scheduler Capture - Process Timeline ({summary.snapshots} snapshots)',
+                fontsize=16, fontweight='bold')
+
+    legend_elements = [
+        mpatches.Patch(facecolor=colors['test_cpu'], edgecolor='black',
+                      label='CPU-Bound Process'),
+        mpatches.Patch(facecolor=colors['test_io'], edgecolor='black',
+                      label='I/O-Bound Process'),
+        mpatches.Patch(facecolor=colors['test_mixed'], edgecolor='black',
+                      label='Mixed Workload Process')
+    ]
+    fig.legend(handles=legend_elements, loc='upper right', fontsize=10)
+
+    plt.tight_layout(rect=[0, 0, 1, 0.96])
+
+    if save_path:
+        plt.savefig(save_path, format=format, dpi=300, bbox_inches='tight')
+        print(f"✓ Gantt chart saved to: {save_path}")
+    else:
+        plt.show()
+
+    plt.close()
+
+
+def capture_timeline(summary: CaptureSummary) -> Dict[str, List[Tuple[str, ProcessData]]]:
+    """Final counters of every test process in a capture, in timeline form."""
+    timeline = {'capture': []}
+    for i in range(len(summary.pid)):
+        name = summary.comms.names[summary.last['comm'][i]]
+        if name.startswith('test_'):
+            timeline['capture'].append((name, summary.process(i)))
+    return timeline
+
+
+def visualize_capture(capture: Path, save: bool, format: str) -> int:
+    """Load a capture file and render its charts next to it."""
+    if not capture.exists():
+        print(f"Error: Capture file not found: {capture}")
+        return 1
+
+    print(f"Loading capture from: {capture}")
+    summary = summarize_capture(capture)
+    print(f"✓ Capture loaded: {summary.snapshots} snapshots, {summary.rows} rows, "
+          f"{len(summary.pid)} processes")
+
+    gantt_path = comparison_path = None
+    if save:
+        gantt_path = capture.with_name(f"gantt_chart_{capture.stem}.{format}")
+        comparison_path = capture.with_name(f"comparison_chart_{capture.stem}.{format}")
+
+    print("Creating Gantt chart...")
+    create_capture_gantt_chart(summary, save_path=str(gantt_path) if gantt_path else None,
+                               format=format)
+
+    print("Creating comparison chart...")
+    create_comparison_chart(capture_timeline(summary),
+                            save_path=str(comparison_path) if comparison_path else None,
+                            format=format)
+
+    print("\n✓ Visualization complete!")
+    return 0
+
+
 def create_comparison_chart(timeline: Dict[str, List[Tuple[str, ProcessData]]], 
                            save_path: Optional[str] = None,
                            format: str = 'png'):
@@ -446,8 +937,14 @@ def main():
                        help='Save charts as files instead of displaying')
     parser.add_argument('--format', choices=['png', 'pdf', 'svg'], default='png',
                        help='Output format for saved charts (default: png)')
+    parser.add_argument('--capture', default=None,
+                       help='Chart a sched_collector capture (.sts or sched_ts_dump CSV) '
+                            'on its real timeline')
     
     args = parser.parse_args()
+
+    if args.capture:
+        return visualize_capture(Path(args.capture), args.save, args.format)
     
     # Find results directory
     results_path = Path(args.results_dir)
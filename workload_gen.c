@@ -0,0 +1,1119 @@
+/*
+ * workload_gen.c - Configurable workload generator
+ *
+ * Runs groups of threads described by a profile, so a production mix can be
+ * reproduced instead of the fixed test_cpu/test_io/test_mixed loads. Each
+ * group has its own kind, thread count, nice value, scheduling policy and
+ * CPU affinity. Results (per-thread throughput and per-operation latency
+ * percentiles) are written as JSON.
+ *
+ * Profile format (one directive per line, '#' starts a comment):
+ *
+ *   duration 30
+ *   group name=web kind=sleep threads=8 hz=200 nice=-5
+ *   group name=batch kind=cpu threads=4 policy=batch nice=10 cpus=2-3
+ *
+ * Group kinds and their operation:
+ *   cpu    one block of the test_cpu arithmetic kernel
+ *   io     one I/O on a private file, see I/O modes below
+ *   sleep  one wakeup at hz per thread; latency is lateness past the deadline
+ *   pipe   one ping-pong round trip with a private echo thread
+ *   futex  acquire/release of one of `locks` shared mutexes, held for hold_ns
+ *   fork   fork + child exit + waitpid
+ *
+ * Common group keys: name, kind, threads, nice, policy (other, batch, idle,
+ * fifo, rr; default inherits the launcher's), prio (fifo/rr only),
+ * cpus (e.g. 0-3,6).
+ *
+ * I/O modes (io groups, key mode=):
+ *   sync      test_io cycle: 4 KiB write + read + fsync (default)
+ *   buffered  random bs-sized pread/pwrite through the page cache
+ *   fsync     as buffered, with fsync after every write
+ *   direct    as buffered, with O_DIRECT
+ *   uring     io_uring with qd requests in flight, submitted batch at a time;
+ *             direct=1 adds O_DIRECT
+ * I/O keys: bs, file_mb, write_pct, dir, sleep_us (default 1000 for sync,
+ * 0 otherwise). IOPS is ops_per_sec; latency is per request (submission to
+ * completion for uring).
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <linux/io_uring.h>
+
+#define DEFAULT_DURATION 10
+#define MAX_GROUPS 32
+#define MAX_LINE 1024
+#define BUFFER_SIZE 4096
+
+/*
+ * Log-linear latency histogram: 2^HIST_SUB_BITS sub-buckets per power of
+ * two, so any recorded value is within 12.5% of the reported one.
+ */
+#define HIST_SUB_BITS 3
+#define HIST_SUB_COUNT (1 << HIST_SUB_BITS)
+#define HIST_BUCKETS (64 * HIST_SUB_COUNT)
+
+enum group_kind {
+    KIND_CPU,
+    KIND_IO,
+    KIND_SLEEP,
+    KIND_PIPE,
+    KIND_FUTEX,
+    KIND_FORK,
+};
+
+static const char *kind_names[] = { "cpu", "io", "sleep", "pipe", "futex", "fork" };
+
+enum io_mode {
+    IO_SYNC,
+    IO_BUFFERED,
+    IO_FSYNC,
+    IO_DIRECT,
+    IO_URING,
+};
+
+static const char *io_mode_names[] = { "sync", "buffered", "fsync", "direct", "uring" };
+
+typedef struct {
+    char name[64];
+    enum group_kind kind;
+    int threads;
+    int nice;
+    int policy;         // -1: inherit from the launching process
+    int prio;
+    int has_affinity;
+    cpu_set_t cpus;
+    // Kind-specific parameters
+    int hz;
+    int sleep_us;
+    int locks;
+    int hold_ns;
+    enum io_mode io_mode;
+    int qd;
+    int batch;
+    int bs;
+    int file_mb;
+    int write_pct;
+    int direct;
+    char dir[128];
+    pthread_mutex_t *lock_array;
+} group_t;
+
+typedef struct {
+    group_t *group;
+    int index;
+    pid_t tid;
+    int io_fd;              // Test file opened before the start barrier
+    char io_path[256];
+    unsigned long long ops;
+    unsigned long long errors;
+    unsigned long long hist[HIST_BUCKETS];
+} worker_t;
+
+volatile int keep_running = 1;
+pthread_barrier_t start_barrier;
+
+group_t groups[MAX_GROUPS];
+int num_groups = 0;
+
+static unsigned long long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/*
+ * Histogram helpers
+ */
+static int hist_index(unsigned long long ns) {
+    int msb, shift;
+
+    if (ns < HIST_SUB_COUNT)
+        return ns;
+    msb = 63 - __builtin_clzll(ns);
+    shift = msb - HIST_SUB_BITS;
+    return ((shift + 1) << HIST_SUB_BITS) + ((ns >> shift) & (HIST_SUB_COUNT - 1));
+}
+
+static unsigned long long hist_value(int idx) {
+    int shift;
+
+    if (idx < HIST_SUB_COUNT)
+        return idx;
+    shift = (idx >> HIST_SUB_BITS) - 1;
+    // Upper edge of the bucket
+    return ((unsigned long long)(HIST_SUB_COUNT + (idx & (HIST_SUB_COUNT - 1)) + 1) << shift) - 1;
+}
+
+static inline void hist_record(worker_t *w, unsigned long long ns) {
+    w->hist[hist_index(ns)]++;
+    w->ops++;
+}
+
+static unsigned long long hist_percentile(const unsigned long long *hist,
+                                          unsigned long long total, double pct) {
+    unsigned long long target, seen = 0;
+
+    if (total == 0)
+        return 0;
+    target = (unsigned long long)(pct / 100.0 * total);
+    if (target >= total)
+        target = total - 1;
+    for (int i = 0; i < HIST_BUCKETS; i++) {
+        seen += hist[i];
+        if (seen > target)
+            return hist_value(i);
+    }
+    return hist_value(HIST_BUCKETS - 1);
+}
+
+/*
+ * Operation bodies - each loops until keep_running drops
+ */
+static void run_cpu(worker_t *w) {
+    volatile unsigned long long result = 0;
+
+    while (keep_running) {
+        unsigned long long t0 = now_ns();
+        for (int i = 0; i < 100000; i++) {
+            result += i * i;
+            result = result % 1000000;
+        }
+        hist_record(w, now_ns() - t0);
+    }
+}
+
+/*
+ * I/O helpers
+ */
+static void io_filename(worker_t *w, char *buf, size_t len) {
+    snprintf(buf, len, "%s/workload_%d_%s_%d",
+             w->group->dir, getpid(), w->group->name, w->index);
+}
+
+/*
+ * Open and pre-fill the test file so reads hit real blocks.
+ * Returns the fd or -1.
+ */
+static int io_open_prefilled(worker_t *w, const char *filename, int direct) {
+    group_t *g = w->group;
+    off_t size = (off_t)g->file_mb << 20;
+    void *chunk;
+    int fd;
+
+    fd = open(filename, O_CREAT | O_RDWR | O_TRUNC | (direct ? O_DIRECT : 0), 0644);
+    if (fd < 0) {
+        fprintf(stderr, "[%s/%d] open %s: %s\n", g->name, w->index, filename, strerror(errno));
+        return -1;
+    }
+
+    if (posix_memalign(&chunk, 4096, 1 << 20) != 0) {
+        close(fd);
+        return -1;
+    }
+    memset(chunk, 'W', 1 << 20);
+    for (off_t off = 0; off < size; off += 1 << 20) {
+        if (pwrite(fd, chunk, 1 << 20, off) != 1 << 20) {
+            fprintf(stderr, "[%s/%d] prefill: %s\n", g->name, w->index, strerror(errno));
+            free(chunk);
+            close(fd);
+            return -1;
+        }
+    }
+    fsync(fd);
+    free(chunk);
+    return fd;
+}
+
+static inline off_t io_random_offset(group_t *g, unsigned int *seed) {
+    off_t blocks = ((off_t)g->file_mb << 20) / g->bs;
+    return (off_t)(rand_r(seed) % blocks) * g->bs;
+}
+
+static inline int io_is_write(group_t *g, unsigned int *seed) {
+    return (int)(rand_r(seed) % 100) < g->write_pct;
+}
+
+/*
+ * Create (and for the random-access modes pre-fill) the worker's test file.
+ * Runs before the start barrier so setup never counts against the workload.
+ */
+static void io_setup(worker_t *w) {
+    group_t *g = w->group;
+
+    io_filename(w, w->io_path, sizeof(w->io_path));
+    switch (g->io_mode) {
+    case IO_SYNC:
+        w->io_fd = open(w->io_path, O_CREAT | O_RDWR | O_TRUNC, 0644);
+        if (w->io_fd < 0)
+            perror("Failed to create I/O test file");
+        break;
+    case IO_URING:
+        w->io_fd = io_open_prefilled(w, w->io_path, g->direct);
+        break;
+    default:
+        w->io_fd = io_open_prefilled(w, w->io_path, g->io_mode == IO_DIRECT);
+        break;
+    }
+}
+
+/*
+ * mode=sync: the test_io cycle - write, read back and fsync one block
+ */
+static void run_io_sync(worker_t *w) {
+    char buffer[BUFFER_SIZE];
+    int fd = w->io_fd;
+
+    memset(buffer, 'W', BUFFER_SIZE);
+
+    while (keep_running) {
+        unsigned long long t0 = now_ns();
+        if (pwrite(fd, buffer, BUFFER_SIZE, 0) != BUFFER_SIZE ||
+            pread(fd, buffer, BUFFER_SIZE, 0) != BUFFER_SIZE ||
+            fsync(fd) < 0) {
+            w->errors++;
+        } else {
+            hist_record(w, now_ns() - t0);
+        }
+        if (w->group->sleep_us > 0)
+            usleep(w->group->sleep_us);
+    }
+
+    close(fd);
+    unlink(w->io_path);
+}
+
+/*
+ * mode=buffered/fsync/direct: one blocking random read or write per op
+ */
+static void run_io_blocking(worker_t *w) {
+    group_t *g = w->group;
+    unsigned int seed = w->index + 1;
+    void *buffer;
+    int fd = w->io_fd;
+
+    if (posix_memalign(&buffer, 4096, g->bs) != 0) {
+        w->errors++;
+        close(fd);
+        unlink(w->io_path);
+        return;
+    }
+    memset(buffer, 'W', g->bs);
+
+    while (keep_running) {
+        off_t off = io_random_offset(g, &seed);
+        int is_write = io_is_write(g, &seed);
+        unsigned long long t0 = now_ns();
+        ssize_t ret;
+
+        if (is_write) {
+            ret = pwrite(fd, buffer, g->bs, off);
+            if (ret == g->bs && g->io_mode == IO_FSYNC && fsync(fd) < 0)
+                ret = -1;
+        } else {
+            ret = pread(fd, buffer, g->bs, off);
+        }
+
+        if (ret == g->bs)
+            hist_record(w, now_ns() - t0);
+        else
+            w->errors++;
+        if (g->sleep_us > 0)
+            usleep(g->sleep_us);
+    }
+
+    free(buffer);
+    close(fd);
+    unlink(w->io_path);
+}
+
+/*
+ * Minimal io_uring ring driven through raw syscalls (no liburing)
+ */
+typedef struct {
+    int fd;
+    unsigned *sq_tail, *sq_mask, *sq_array;
+    unsigned *cq_head, *cq_tail, *cq_mask;
+    struct io_uring_sqe *sqes;
+    struct io_uring_cqe *cqes;
+    void *sq_ring, *cq_ring;
+    size_t sq_ring_size, cq_ring_size, sqes_size;
+} uring_t;
+
+static int uring_init(uring_t *r, unsigned entries) {
+    struct io_uring_params params;
+
+    memset(&params, 0, sizeof(params));
+    memset(r, 0, sizeof(*r));
+    r->fd = syscall(__NR_io_uring_setup, entries, &params);
+    if (r->fd < 0)
+        return -1;
+
+    r->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    r->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        if (r->cq_ring_size > r->sq_ring_size)
+            r->sq_ring_size = r->cq_ring_size;
+        r->cq_ring_size = r->sq_ring_size;
+    }
+
+    r->sq_ring = mmap(NULL, r->sq_ring_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_SQ_RING);
+    if (r->sq_ring == MAP_FAILED)
+        goto fail;
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        r->cq_ring = r->sq_ring;
+    } else {
+        r->cq_ring = mmap(NULL, r->cq_ring_size, PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_CQ_RING);
+        if (r->cq_ring == MAP_FAILED)
+            goto fail;
+    }
+    r->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    r->sqes = mmap(NULL, r->sqes_size, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_SQES);
+    if (r->sqes == MAP_FAILED)
+        goto fail;
+
+    r->sq_tail = (unsigned *)((char *)r->sq_ring + params.sq_off.tail);
+    r->sq_mask = (unsigned *)((char *)r->sq_ring + params.sq_off.ring_mask);
+    r->sq_array = (unsigned *)((char *)r->sq_ring + params.sq_off.array);
+    r->cq_head = (unsigned *)((char *)r->cq_ring + params.cq_off.head);
+    r->cq_tail = (unsigned *)((char *)r->cq_ring + params.cq_off.tail);
+    r->cq_mask = (unsigned *)((char *)r->cq_ring + params.cq_off.ring_mask);
+    r->cqes = (struct io_uring_cqe *)((char *)r->cq_ring + params.cq_off.cqes);
+    return 0;
+
+fail:
+    close(r->fd);
+    r->fd = -1;
+    return -1;
+}
+
+static void uring_exit(uring_t *r) {
+    munmap(r->sqes, r->sqes_size);
+    if (r->cq_ring != r->sq_ring)
+        munmap(r->cq_ring, r->cq_ring_size);
+    munmap(r->sq_ring, r->sq_ring_size);
+    close(r->fd);
+}
+
+/*
+ * mode=uring: keep up to qd requests in flight, submitting batch at a time.
+ * Latency is submission to completion for each request.
+ */
+static void run_io_uring(worker_t *w) {
+    group_t *g = w->group;
+    unsigned int seed = w->index + 1;
+    unsigned long long *submit_ns;
+    int *free_slots;
+    char *buffers;
+    int free_count, inflight = 0, failed = 0;
+    unsigned queued = 0;    // SQEs in the ring the kernel has not consumed yet
+    uring_t ring;
+    int fd = w->io_fd;
+
+    if (uring_init(&ring, g->qd) < 0) {
+        fprintf(stderr, "[%s/%d] io_uring_setup: %s\n", g->name, w->index, strerror(errno));
+        w->errors++;
+        close(fd);
+        unlink(w->io_path);
+        return;
+    }
+
+    submit_ns = calloc(g->qd, sizeof(*submit_ns));
+    free_slots = malloc(g->qd * sizeof(*free_slots));
+    if (posix_memalign((void **)&buffers, 4096, (size_t)g->qd * g->bs) != 0)
+        buffers = NULL;
+    if (!submit_ns || !free_slots || !buffers) {
+        w->errors++;
+        goto out;
+    }
+    memset(buffers, 'W', (size_t)g->qd * g->bs);
+    for (int i = 0; i < g->qd; i++)
+        free_slots[i] = i;
+    free_count = g->qd;
+
+    for (;;) {
+        unsigned added = 0, wait_nr, head, tail;
+        int ret;
+
+        // Queue a full batch once enough slots are free
+        if (keep_running && !failed && free_count >= g->batch) {
+            unsigned sq_tail = *ring.sq_tail;
+            unsigned long long t0 = now_ns();
+
+            for (int i = 0; i < g->batch; i++) {
+                int slot = free_slots[--free_count];
+                unsigned idx = sq_tail & *ring.sq_mask;
+                struct io_uring_sqe *sqe = &ring.sqes[idx];
+
+                memset(sqe, 0, sizeof(*sqe));
+                sqe->opcode = io_is_write(g, &seed) ? IORING_OP_WRITE : IORING_OP_READ;
+                sqe->fd = fd;
+                sqe->addr = (unsigned long)(buffers + (size_t)slot * g->bs);
+                sqe->len = g->bs;
+                sqe->off = io_random_offset(g, &seed);
+                sqe->user_data = slot;
+                ring.sq_array[idx] = idx;
+                submit_ns[slot] = t0;
+                sq_tail++;
+                added++;
+            }
+            __atomic_store_n(ring.sq_tail, sq_tail, __ATOMIC_RELEASE);
+        }
+
+        queued += added;
+        if (failed)
+            queued = 0;     // Never handed to the kernel; nothing to wait for
+        if (queued == 0 && inflight == 0)
+            break;
+
+        // The kernel may consume only part of the queue; count what it took
+        // and offer the rest again on the next pass
+        wait_nr = added == 0 && inflight > 0 ? 1 : 0;
+        do {
+            ret = syscall(__NR_io_uring_enter, ring.fd, queued, wait_nr,
+                          wait_nr ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+        } while (ret < 0 && errno == EINTR);
+        if (ret < 0) {
+            fprintf(stderr, "[%s/%d] io_uring_enter: %s\n", g->name, w->index, strerror(errno));
+            w->errors++;
+            // Stop issuing, but keep reaping until the kernel is done with
+            // every buffer; if even waiting fails they cannot be freed safely
+            if (failed || inflight == 0)
+                break;
+            failed = 1;
+            continue;
+        }
+        inflight += ret;
+        queued -= ret;
+
+        // Reap completions
+        head = *ring.cq_head;
+        tail = __atomic_load_n(ring.cq_tail, __ATOMIC_ACQUIRE);
+        if (head != tail) {
+            unsigned long long t1 = now_ns();
+            for (; head != tail; head++) {
+                struct io_uring_cqe *cqe = &ring.cqes[head & *ring.cq_mask];
+                int slot = cqe->user_data;
+
+                if (cqe->res == g->bs)
+                    hist_record(w, t1 - submit_ns[slot]);
+                else
+                    w->errors++;
+                free_slots[free_count++] = slot;
+                inflight--;
+            }
+            __atomic_store_n(ring.cq_head, head, __ATOMIC_RELEASE);
+        }
+    }
+
+out:
+    uring_exit(&ring);
+    free(submit_ns);
+    free(free_slots);
+    // Leak rather than free memory the kernel may still be reading or filling
+    if (inflight == 0)
+        free(buffers);
+    close(fd);
+    unlink(w->io_path);
+}
+
+static void run_io(worker_t *w) {
+    if (w->io_fd < 0) {
+        w->errors++;
+        return;
+    }
+    switch (w->group->io_mode) {
+    case IO_SYNC:  run_io_sync(w);     break;
+    case IO_URING: run_io_uring(w);    break;
+    default:       run_io_blocking(w); break;
+    }
+}
+
+static void run_sleep(worker_t *w) {
+    struct timespec next, now;
+    long period_ns = 1000000000L / w->group->hz;
+
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    while (keep_running) {
+        next.tv_nsec += period_ns;
+        while (next.tv_nsec >= 1000000000L) {
+            next.tv_nsec -= 1000000000L;
+            next.tv_sec++;
+        }
+        if (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL) != 0) {
+            w->errors++;
+            continue;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        hist_record(w, (now.tv_sec - next.tv_sec) * 1000000000LL +
+                       (now.tv_nsec - next.tv_nsec));
+    }
+}
+
+static void* pipe_echo(void *arg) {
+    int *fds = arg;   // fds[0]: read ping, fds[1]: write pong
+    char token;
+
+    while (read(fds[0], &token, 1) == 1) {
+        if (write(fds[1], &token, 1) != 1)
+            break;
+    }
+    return NULL;
+}
+
+static void run_pipe(worker_t *w) {
+    int ping[2], pong[2], echo_fds[2];
+    pthread_t echo;
+    char token = 'p';
+
+    if (pipe(ping) < 0 || pipe(pong) < 0) {
+        perror("pipe");
+        w->errors++;
+        return;
+    }
+    echo_fds[0] = ping[0];
+    echo_fds[1] = pong[1];
+    // The echo thread inherits this thread's policy, nice value and affinity
+    if (pthread_create(&echo, NULL, pipe_echo, echo_fds) != 0) {
+        perror("Failed to create echo thread");
+        w->errors++;
+        return;
+    }
+
+    while (keep_running) {
+        unsigned long long t0 = now_ns();
+        if (write(ping[1], &token, 1) != 1 || read(pong[0], &token, 1) != 1) {
+            w->errors++;
+            break;
+        }
+        hist_record(w, now_ns() - t0);
+    }
+
+    close(ping[1]);
+    pthread_join(echo, NULL);
+    close(ping[0]);
+    close(pong[0]);
+    close(pong[1]);
+}
+
+static void run_futex(worker_t *w) {
+    group_t *g = w->group;
+    unsigned int seed = w->index;
+
+    while (keep_running) {
+        pthread_mutex_t *lock = &g->lock_array[rand_r(&seed) % g->locks];
+        unsigned long long t0 = now_ns();
+        pthread_mutex_lock(lock);
+        hist_record(w, now_ns() - t0);
+        if (g->hold_ns > 0) {
+            unsigned long long until = now_ns() + g->hold_ns;
+            while (now_ns() < until)
+                ;
+        }
+        pthread_mutex_unlock(lock);
+    }
+}
+
+static void run_fork(worker_t *w) {
+    while (keep_running) {
+        unsigned long long t0 = now_ns();
+        pid_t pid = fork();
+        if (pid < 0) {
+            w->errors++;
+            usleep(1000);
+            continue;
+        }
+        if (pid == 0)
+            _exit(0);
+        waitpid(pid, NULL, 0);
+        hist_record(w, now_ns() - t0);
+    }
+}
+
+/*
+ * Apply the group's scheduling attributes to the calling thread
+ */
+static void apply_sched_attrs(worker_t *w) {
+    group_t *g = w->group;
+    struct sched_param param = { .sched_priority = 0 };
+
+    if (g->policy == SCHED_FIFO || g->policy == SCHED_RR)
+        param.sched_priority = g->prio;
+    if (g->policy >= 0 && sched_setscheduler(0, g->policy, &param) < 0)
+        fprintf(stderr, "[%s/%d] sched_setscheduler: %s\n", g->name, w->index, strerror(errno));
+
+    if (g->nice != 0 && setpriority(PRIO_PROCESS, w->tid, g->nice) < 0)
+        fprintf(stderr, "[%s/%d] setpriority: %s\n", g->name, w->index, strerror(errno));
+
+    if (g->has_affinity && sched_setaffinity(0, sizeof(g->cpus), &g->cpus) < 0)
+        fprintf(stderr, "[%s/%d] sched_setaffinity: %s\n", g->name, w->index, strerror(errno));
+}
+
+void* worker_main(void *arg) {
+    worker_t *w = arg;
+
+    w->tid = syscall(SYS_gettid);
+    apply_sched_attrs(w);
+    if (w->group->kind == KIND_IO)
+        io_setup(w);
+    pthread_barrier_wait(&start_barrier);
+
+    switch (w->group->kind) {
+    case KIND_CPU:   run_cpu(w);   break;
+    case KIND_IO:    run_io(w);    break;
+    case KIND_SLEEP: run_sleep(w); break;
+    case KIND_PIPE:  run_pipe(w);  break;
+    case KIND_FUTEX: run_futex(w); break;
+    case KIND_FORK:  run_fork(w);  break;
+    }
+    return NULL;
+}
+
+/*
+ * Profile parsing
+ */
+static int parse_cpus(const char *list, cpu_set_t *set) {
+    char *copy = strdup(list);
+    char *save = NULL;
+    int ok = 1;
+
+    CPU_ZERO(set);
+    for (char *tok = strtok_r(copy, ",", &save); tok; tok = strtok_r(NULL, ",", &save)) {
+        int lo, hi;
+        if (sscanf(tok, "%d-%d", &lo, &hi) == 2) {
+            // Range
+        } else if (sscanf(tok, "%d", &lo) == 1) {
+            hi = lo;
+        } else {
+            ok = 0;
+            break;
+        }
+        if (lo < 0 || hi < lo || hi >= CPU_SETSIZE) {
+            ok = 0;
+            break;
+        }
+        for (int c = lo; c <= hi; c++)
+            CPU_SET(c, set);
+    }
+    free(copy);
+    return ok;
+}
+
+static int parse_policy(const char *name) {
+    if (!strcmp(name, "other")) return SCHED_OTHER;
+    if (!strcmp(name, "batch")) return SCHED_BATCH;
+    if (!strcmp(name, "idle"))  return SCHED_IDLE;
+    if (!strcmp(name, "fifo"))  return SCHED_FIFO;
+    if (!strcmp(name, "rr"))    return SCHED_RR;
+    return -1;
+}
+
+static const char* policy_name(int policy) {
+    switch (policy) {
+    case SCHED_BATCH: return "batch";
+    case SCHED_IDLE:  return "idle";
+    case SCHED_FIFO:  return "fifo";
+    case SCHED_RR:    return "rr";
+    case SCHED_OTHER: return "other";
+    default:          return "inherit";
+    }
+}
+
+/*
+ * Parse "key=value key=value ..." into a new group. Returns 0 on success.
+ */
+int parse_group(const char *spec) {
+    group_t *g;
+    char *copy, *save = NULL;
+    int kind_set = 0;
+
+    if (num_groups >= MAX_GROUPS) {
+        fprintf(stderr, "Too many groups (max %d)\n", MAX_GROUPS);
+        return -1;
+    }
+
+    g = &groups[num_groups];
+    memset(g, 0, sizeof(*g));
+    snprintf(g->name, sizeof(g->name), "group%d", num_groups);
+    g->threads = 1;
+    g->policy = -1;
+    g->prio = 1;
+    g->hz = 100;
+    g->sleep_us = -1;
+    g->locks = 1;
+    g->io_mode = IO_SYNC;
+    g->qd = 32;
+    g->batch = 1;
+    g->bs = 4096;
+    g->file_mb = 64;
+    g->write_pct = 50;
+    snprintf(g->dir, sizeof(g->dir), "/tmp");
+
+    copy = strdup(spec);
+    for (char *tok = strtok_r(copy, " \t\n", &save); tok; tok = strtok_r(NULL, " \t\n", &save)) {
+        char *value = strchr(tok, '=');
+        if (!value) {
+            fprintf(stderr, "Bad group option '%s' (expected key=value)\n", tok);
+            free(copy);
+            return -1;
+        }
+        *value++ = '\0';
+
+        if (!strcmp(tok, "name")) {
+            snprintf(g->name, sizeof(g->name), "%s", value);
+        } else if (!strcmp(tok, "kind")) {
+            int found = 0;
+            for (size_t k = 0; k < sizeof(kind_names) / sizeof(kind_names[0]); k++) {
+                if (!strcmp(value, kind_names[k])) {
+                    g->kind = k;
+                    found = 1;
+                }
+            }
+            if (!found) {
+                fprintf(stderr, "Unknown group kind '%s'\n", value);
+                free(copy);
+                return -1;
+            }
+            kind_set = 1;
+        } else if (!strcmp(tok, "threads")) {
+            g->threads = atoi(value);
+        } else if (!strcmp(tok, "nice")) {
+            g->nice = atoi(value);
+        } else if (!strcmp(tok, "policy")) {
+            g->policy = parse_policy(value);
+            if (g->policy < 0) {
+                fprintf(stderr, "Unknown policy '%s'\n", value);
+                free(copy);
+                return -1;
+            }
+        } else if (!strcmp(tok, "prio")) {
+            g->prio = atoi(value);
+        } else if (!strcmp(tok, "cpus")) {
+            if (!parse_cpus(value, &g->cpus)) {
+                fprintf(stderr, "Bad CPU list '%s'\n", value);
+                free(copy);
+                return -1;
+            }
+            g->has_affinity = 1;
+        } else if (!strcmp(tok, "hz")) {
+            g->hz = atoi(value);
+        } else if (!strcmp(tok, "sleep_us")) {
+            g->sleep_us = atoi(value);
+        } else if (!strcmp(tok, "locks")) {
+            g->locks = atoi(value);
+        } else if (!strcmp(tok, "hold_ns")) {
+            g->hold_ns = atoi(value);
+        } else if (!strcmp(tok, "mode")) {
+            int found = 0;
+            for (size_t m = 0; m < sizeof(io_mode_names) / sizeof(io_mode_names[0]); m++) {
+                if (!strcmp(value, io_mode_names[m])) {
+                    g->io_mode = m;
+                    found = 1;
+                }
+            }
+            if (!found) {
+                fprintf(stderr, "Unknown I/O mode '%s'\n", value);
+                free(copy);
+                return -1;
+            }
+        } else if (!strcmp(tok, "qd")) {
+            g->qd = atoi(value);
+        } else if (!strcmp(tok, "batch")) {
+            g->batch = atoi(value);
+        } else if (!strcmp(tok, "bs")) {
+            g->bs = atoi(value);
+        } else if (!strcmp(tok, "file_mb")) {
+            g->file_mb = atoi(value);
+        } else if (!strcmp(tok, "write_pct")) {
+            g->write_pct = atoi(value);
+        } else if (!strcmp(tok, "direct")) {
+            g->direct = atoi(value);
+        } else if (!strcmp(tok, "dir")) {
+            snprintf(g->dir, sizeof(g->dir), "%s", value);
+        } else {
+            fprintf(stderr, "Unknown group option '%s'\n", tok);
+            free(copy);
+            return -1;
+        }
+    }
+    free(copy);
+
+    if (!kind_set) {
+        fprintf(stderr, "Group '%s' has no kind\n", g->name);
+        return -1;
+    }
+    if (g->sleep_us < 0)
+        g->sleep_us = g->io_mode == IO_SYNC ? 1000 : 0;
+    if (g->threads < 1 || g->hz < 1 || g->locks < 1 ||
+        g->nice < -20 || g->nice > 19 ||
+        g->qd < 1 || g->batch < 1 || g->batch > g->qd ||
+        g->bs < 512 || g->bs % 512 != 0 || g->file_mb < 1 ||
+        g->write_pct < 0 || g->write_pct > 100) {
+        fprintf(stderr, "Invalid parameters for group '%s'\n", g->name);
+        return -1;
+    }
+
+    num_groups++;
+    return 0;
+}
+
+int load_profile(const char *path, int *duration) {
+    FILE *fp = fopen(path, "r");
+    char line[MAX_LINE];
+    int lineno = 0;
+
+    if (!fp) {
+        perror(path);
+        return -1;
+    }
+
+    while (fgets(line, sizeof(line), fp)) {
+        char *p = line;
+        char *hash = strchr(line, '#');
+
+        lineno++;
+        if (hash)
+            *hash = '\0';
+        while (*p == ' ' || *p == '\t')
+            p++;
+        if (*p == '\0' || *p == '\n')
+            continue;
+
+        if (!strncmp(p, "duration", 8)) {
+            *duration = atoi(p + 8);
+        } else if (!strncmp(p, "group", 5)) {
+            if (parse_group(p + 5) < 0) {
+                fprintf(stderr, "%s:%d: invalid group\n", path, lineno);
+                fclose(fp);
+                return -1;
+            }
+        } else {
+            fprintf(stderr, "%s:%d: unknown directive\n", path, lineno);
+            fclose(fp);
+            return -1;
+        }
+    }
+
+    fclose(fp);
+    return 0;
+}
+
+/*
+ * JSON report
+ */
+static void print_latency(FILE *out, const unsigned long long *hist, unsigned long long total) {
+    fprintf(out, "\"latency_ns\": {\"p50\": %llu, \"p90\": %llu, \"p99\": %llu, "
+            "\"p999\": %llu, \"max\": %llu}",
+            hist_percentile(hist, total, 50.0),
+            hist_percentile(hist, total, 90.0),
+            hist_percentile(hist, total, 99.0),
+            hist_percentile(hist, total, 99.9),
+            hist_percentile(hist, total, 100.0));
+}
+
+static void print_json_string(FILE *out, const char *s) {
+    fputc('"', out);
+    for (; *s; s++) {
+        unsigned char c = *s;
+        if (c == '"' || c == '\\')
+            fprintf(out, "\\%c", c);
+        else if (c < 0x20)
+            fprintf(out, "\\u%04x", c);
+        else
+            fputc(c, out);
+    }
+    fputc('"', out);
+}
+
+void write_report(FILE *out, worker_t *workers, double elapsed) {
+    struct rusage ru;
+    int w = 0;
+
+    // Whole-process counters: the module only samples the thread group leader
+    getrusage(RUSAGE_SELF, &ru);
+
+    fprintf(out, "{\n  \"pid\": %d,\n  \"duration_s\": %.3f,\n", getpid(), elapsed);
+    fprintf(out, "  \"rusage\": {\"voluntary_cs\": %ld, \"involuntary_cs\": %ld, "
+            "\"user_s\": %.3f, \"sys_s\": %.3f},\n",
+            ru.ru_nvcsw, ru.ru_nivcsw,
+            ru.ru_utime.tv_sec + ru.ru_utime.tv_usec / 1e6,
+            ru.ru_stime.tv_sec + ru.ru_stime.tv_usec / 1e6);
+    fprintf(out, "  \"groups\": [\n");
+
+    for (int gi = 0; gi < num_groups; gi++) {
+        group_t *g = &groups[gi];
+        unsigned long long merged[HIST_BUCKETS] = {0};
+        unsigned long long total_ops = 0, total_errors = 0;
+        int first = w;
+
+        for (int t = 0; t < g->threads; t++, w++) {
+            for (int i = 0; i < HIST_BUCKETS; i++)
+                merged[i] += workers[w].hist[i];
+            total_ops += workers[w].ops;
+            total_errors += workers[w].errors;
+        }
+
+        fprintf(out, "    {\n      \"name\": ");
+        print_json_string(out, g->name);
+        fprintf(out, ", \"kind\": \"%s\", \"threads\": %d, \"nice\": %d, \"policy\": \"%s\",\n",
+                kind_names[g->kind], g->threads, g->nice, policy_name(g->policy));
+        if (g->kind == KIND_IO)
+            fprintf(out, "      \"io_mode\": \"%s\", \"qd\": %d, \"batch\": %d, \"bs\": %d, "
+                    "\"direct\": %d,\n",
+                    io_mode_names[g->io_mode], g->io_mode == IO_URING ? g->qd : 1,
+                    g->io_mode == IO_URING ? g->batch : 1, g->bs,
+                    g->io_mode == IO_DIRECT || (g->io_mode == IO_URING && g->direct));
+        fprintf(out, "      \"ops\": %llu, \"errors\": %llu, \"ops_per_sec\": %.2f,\n      ",
+                total_ops, total_errors, total_ops / elapsed);
+        print_latency(out, merged, total_ops);
+        fprintf(out, ",\n      \"per_thread\": [\n");
+
+        for (int t = 0; t < g->threads; t++) {
+            worker_t *wk = &workers[first + t];
+            fprintf(out, "        {\"tid\": %d, \"ops\": %llu, \"ops_per_sec\": %.2f, ",
+                    wk->tid, wk->ops, wk->ops / elapsed);
+            print_latency(out, wk->hist, wk->ops);
+            fprintf(out, "}%s\n", t + 1 < g->threads ? "," : "");
+        }
+        fprintf(out, "      ]\n    }%s\n", gi + 1 < num_groups ? "," : "");
+    }
+
+    fprintf(out, "  ]\n}\n");
+}
+
+void usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s [-p profile] [-g group_spec]... [-d duration] [-o output.json]\n"
+            "  -p  profile file (see profiles/)\n"
+            "  -g  add a group inline, e.g. -g \"kind=cpu threads=4 nice=5\"\n"
+            "  -d  duration in seconds, overrides the profile (default: %d)\n"
+            "  -o  write the JSON report to a file instead of stdout\n",
+            prog, DEFAULT_DURATION);
+}
+
+int main(int argc, char *argv[]) {
+    int duration = DEFAULT_DURATION;
+    int duration_override = 0;
+    const char *output = NULL;
+    int total_threads = 0;
+    worker_t *workers;
+    pthread_t *threads;
+    unsigned long long start, end;
+    FILE *out = stdout;
+    int opt, w = 0;
+
+    // Parse arguments
+    while ((opt = getopt(argc, argv, "p:g:d:o:h")) != -1) {
+        switch (opt) {
+        case 'p':
+            if (load_profile(optarg, &duration) < 0)
+                return 1;
+            break;
+        case 'g':
+            if (parse_group(optarg) < 0)
+                return 1;
+            break;
+        case 'd':
+            duration_override = atoi(optarg);
+            break;
+        case 'o':
+            output = optarg;
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (duration_override)
+        duration = duration_override;
+    if (num_groups == 0 || duration < 1) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    for (int gi = 0; gi < num_groups; gi++) {
+        group_t *g = &groups[gi];
+        total_threads += g->threads;
+        if (g->kind == KIND_FUTEX) {
+            g->lock_array = malloc(g->locks * sizeof(pthread_mutex_t));
+            if (!g->lock_array) {
+                perror("Failed to allocate locks");
+                return 1;
+            }
+            for (int i = 0; i < g->locks; i++)
+                pthread_mutex_init(&g->lock_array[i], NULL);
+        }
+    }
+
+    workers = calloc(total_threads, sizeof(worker_t));
+    threads = malloc(total_threads * sizeof(pthread_t));
+    if (!workers || !threads) {
+        perror("Failed to allocate thread array");
+        return 1;
+    }
+
+    fprintf(stderr, "=== Workload Generator ===\n");
+    fprintf(stderr, "PID: %d\n", getpid());
+    fprintf(stderr, "Groups: %d, threads: %d, duration: %d seconds\n",
+            num_groups, total_threads, duration);
+    fprintf(stderr, "Use: cat /proc/sched_stats to monitor scheduler behavior\n\n");
+
+    pthread_barrier_init(&start_barrier, NULL, total_threads + 1);
+
+    for (int gi = 0; gi < num_groups; gi++) {
+        for (int t = 0; t < groups[gi].threads; t++, w++) {
+            workers[w].group = &groups[gi];
+            workers[w].index = t;
+            if (pthread_create(&threads[w], NULL, worker_main, &workers[w]) != 0) {
+                perror("Failed to create thread");
+                return 1;
+            }
+        }
+    }
+
+    pthread_barrier_wait(&start_barrier);
+    start = now_ns();
+
+    // Run for specified duration
+    sleep(duration);
+    keep_running = 0;
+    end = now_ns();
+
+    for (int i = 0; i < total_threads; i++)
+        pthread_join(threads[i], NULL);
+
+    if (output) {
+        out = fopen(output, "w");
+        if (!out) {
+            perror(output);
+            return 1;
+        }
+    }
+    write_report(out, workers, (end - start) / 1e9);
+    if (out != stdout)
+        fclose(out);
+
+    for (int gi = 0; gi < num_groups; gi++)
+        free(groups[gi].lock_array);
+    free(workers);
+    free(threads);
+    return 0;
+}